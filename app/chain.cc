@@ -20,6 +20,7 @@ struct ChainTransaction
 {
 public:
   static Database<T>* index;
+  static constexpr size_t MarshalledSize = T::MarshalledSize;
 
 #if defined(INDEXER) || defined(TEST_TWO)
   static int prepare_cowns(char* input)
@@ -31,8 +32,7 @@ public:
       for (int i = 0; i < txm->num_writes; i++)
       {
         txm->cown_ptrs[i] =
-          index->resource_table.get_row_addr(txm->params[i] - 1)
-            ->get_base_addr();
+          index->resource_table.get_base_addr(txm->params[i] - 1);
       }
     }
     else
@@ -40,11 +40,10 @@ public:
       int i, j;
       for (i = 0; i < T::NUM_RESRC_COWN; i++)
         txm->cown_ptrs[i] =
-          index->resource_table.get_row_addr(txm->params[i] - 1)
-            ->get_base_addr();
+          index->resource_table.get_base_addr(txm->params[i] - 1);
       for (j = i; j < T::NUM_COWN; j++)
         txm->cown_ptrs[j] =
-          index->user_table.get_row_addr(txm->params[j] - 1)->get_base_addr();
+          index->user_table.get_base_addr(txm->params[j] - 1);
     }
 
     return T::MarshalledSize;
@@ -64,7 +63,7 @@ public:
 #endif
 
 #ifdef RPC_LATENCY
-  static int parse_and_process(const char* input, ts_type init_time)
+  static int parse_and_process(const char* input, uint64_t init_time)
 #else
   static int parse_and_process(const char* input)
 #endif // RPC_LATENCY
@@ -1733,13 +1732,15 @@ public:
         reinterpret_cast<void*>(txm->cown_ptrs[1]));
 
 #ifdef RPC_LATENCY
-      when(r, u) << [init_time]
+      when(r, u) << [init_time TXN_TRACE_CAPTURE]
 #else
-      when(r, u) << []
+      when(r, u) << [= TXN_TRACE_CAPTURE]
 #endif
         (auto _r, auto _u) {
+          TXN_TRACE_BEGIN();
           SPIN_RUN();
           M_LOG_LATENCY();
+          TXN_TRACE_END();
         };
     }
     else if constexpr (std::is_same_v<T, P2p>)
@@ -1750,13 +1751,15 @@ public:
         reinterpret_cast<void*>(txm->cown_ptrs[1]));
 
 #ifdef RPC_LATENCY
-      when(s, r) << [init_time]
+      when(s, r) << [init_time TXN_TRACE_CAPTURE]
 #else
-      when(s, r) << []
+      when(s, r) << [= TXN_TRACE_CAPTURE]
 #endif
         (auto _s, auto _r) {
+          TXN_TRACE_BEGIN();
           SPIN_RUN();
           M_LOG_LATENCY();
+          TXN_TRACE_END();
         };
     }
     else if constexpr (std::is_same_v<T, Dex>)
@@ -1765,13 +1768,15 @@ public:
         reinterpret_cast<void*>(txm->cown_ptrs[0]));
 
 #ifdef RPC_LATENCY
-      when(r) << [init_time]
+      when(r) << [init_time TXN_TRACE_CAPTURE]
 #else
-      when(r) << []
+      when(r) << [= TXN_TRACE_CAPTURE]
 #endif
         (auto _r) {
+          TXN_TRACE_BEGIN();
           SPIN_RUN();
           M_LOG_LATENCY();
+          TXN_TRACE_END();
         };
     }
     return T::MarshalledSize;
@@ -1788,12 +1793,15 @@ Database<TxnType>* ChainTransaction<TxnType>::index = nullptr;
 int main(int argc, char** argv)
 {
   /* input args parsing */
-  if (argc != 6 || strcmp(argv[1], "-n") != 0)
+  if (argc < 6 || strcmp(argv[1], "-n") != 0)
   {
     fprintf(
       stderr,
       "Usage: ./program -n core_cnt"
-      " <dispatcher_input_file> -i <inter_arrival>\n");
+      " <dispatcher_input_file> -i <inter_arrival>"
+      " [--sweep <Mreq/s>,... [--warmup <s>] [--measure <s>]]"
+      " [--numa <policy>] [--numa-workers <node>]"
+      " [--hugepages thp|2m|1g|<hugetlbfs dir>] [--load-threads <n>]\n");
     return -1;
   }
   uint8_t core_cnt = atoi(argv[2]);
@@ -1807,20 +1815,26 @@ int main(int argc, char** argv)
   db = new Database<TxnType>();
 
   // Create cowns with huge pages and via static allocation
-  void* chain_arr_addr_resource = static_cast<void*>(
-    aligned_alloc_hpage(1024 * (TxnType::NUM_RESRC + NUM_ACCOUNTS)));
+  numa::Config::instance().parse_args(argc, argv);
+  hpage::Config::instance().parse_args(argc, argv);
+  populate::Config::instance().parse_args(argc, argv);
+  const size_t resource_bytes =
+    ResourceTable<TxnType>::stride() * TxnType::NUM_RESRC;
+  const size_t user_bytes = UserTable::stride() * NUM_ACCOUNTS;
+  void* chain_arr_addr_resource =
+    static_cast<void*>(numa::alloc_arena(resource_bytes + user_bytes));
   void* chain_arr_addr_user = static_cast<void*>(
-    static_cast<char*>(chain_arr_addr_resource) + 1024 * TxnType::NUM_RESRC);
+    static_cast<char*>(chain_arr_addr_resource) + resource_bytes);
 
-  ChainGenerator<TxnType> gen(db, chain_arr_addr_resource, chain_arr_addr_user);
-  db->resource_table.start_addr = (void*)chain_arr_addr_resource;
-  db->user_table.start_addr = (void*)chain_arr_addr_user;
+  db->resource_table.attach(chain_arr_addr_resource);
+  db->user_table.attach(chain_arr_addr_user);
+  ChainGenerator<TxnType> gen(db);
 
   gen.generateResources();
   gen.generateUsers();
 
   build_pipelines<ChainTransaction<TxnType>>(
-    core_cnt - 1, input_file, gen_file);
+    core_cnt - 1, input_file, gen_file, argc, argv);
 
   // Cleanup
   delete ChainTransaction<TxnType>::index;
@@ -12,11 +12,11 @@ class __attribute__((packed)) Resource
 public:
   uint64_t value;
   Resource() : value(0) {}
-} __attribute__((aligned(256)));
+};
 
 class __attribute__((packed)) User
 {
 public:
   uint64_t value;
   User() : value(0) {}
-} __attribute__((aligned(256)));
+};
@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include "insert_table.hpp"
+
+struct InsertRow {
+    uint64_t key;
+    char payload[40];
+    InsertRow(uint64_t key_) : key(key_) {}
+};
+
+class InsertTableTest : public ::testing::Test {
+protected:
+    static constexpr int THREADS = 4;
+    static constexpr uint64_t PER_THREAD = 5000;
+    static constexpr uint64_t SHARED = 100;
+    // Keys above the disjoint ranges that every thread inserts
+    static constexpr uint64_t SHARED_BASE = THREADS * PER_THREAD;
+
+    // A first level of 16 slots, so the inserts spill into many levels
+    InsertTable<InsertRow> table{16};
+    uint64_t addrs[THREADS * PER_THREAD] = {};
+    uint64_t shared_addrs[THREADS][SHARED] = {};
+
+    void SetUp() override {
+        std::vector<std::thread> threads;
+        for (int t = 0; t < THREADS; t++) {
+            threads.emplace_back([this, t]() {
+                for (uint64_t i = 0; i < PER_THREAD; i++) {
+                    uint64_t key = t * PER_THREAD + i;
+                    addrs[key] = table.insert(key, key);
+                    if (i < SHARED)
+                        shared_addrs[t][i] = table.insert(SHARED_BASE + i, SHARED_BASE + i);
+                }
+            });
+        }
+        for (auto& t : threads) t.join();
+    }
+};
+
+TEST_F(InsertTableTest, FindsEveryInsertedRow) {
+    for (uint64_t key = 0; key < SHARED_BASE; key++) {
+        ASSERT_NE(addrs[key], 0u);
+        ASSERT_EQ(table.get_base_addr(key), addrs[key]) << "key " << key;
+    }
+    for (uint64_t key = SHARED_BASE + SHARED; key < SHARED_BASE + 2 * SHARED; key++)
+        EXPECT_EQ(table.get_base_addr(key), 0u);
+}
+
+TEST_F(InsertTableTest, DuplicateKeysResolveToOneInsert) {
+    for (uint64_t i = 0; i < SHARED; i++) {
+        uint64_t addr = table.get_base_addr(SHARED_BASE + i);
+        bool found = false;
+        for (int t = 0; t < THREADS; t++) found |= shared_addrs[t][i] == addr;
+        EXPECT_TRUE(found) << "key " << SHARED_BASE + i;
+    }
+}
+
+TEST_F(InsertTableTest, SizeCountsDistinctKeys) {
+    EXPECT_EQ(table.size(), SHARED_BASE + SHARED);
+
+    // Replacing a row keeps the count
+    uint64_t addr = table.insert(0, 0);
+    EXPECT_EQ(table.get_base_addr(0), addr);
+    EXPECT_EQ(table.size(), SHARED_BASE + SHARED);
+}
+
+TEST_F(InsertTableTest, ScanIsInKeyOrder) {
+    std::vector<uint64_t> keys;
+    table.scan(PER_THREAD / 2, SHARED_BASE + 2 * SHARED, [&](uint64_t key, uint64_t addr) {
+        EXPECT_EQ(addr, table.get_base_addr(key));
+        keys.push_back(key);
+    });
+    ASSERT_EQ(keys.size(), SHARED_BASE + SHARED - PER_THREAD / 2);
+    EXPECT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+    EXPECT_EQ(keys.front(), PER_THREAD / 2);
+    EXPECT_EQ(keys.back(), SHARED_BASE + SHARED - 1);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
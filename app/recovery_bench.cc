@@ -0,0 +1,291 @@
+// Recovery benchmark with crash injection.
+//
+// Runs a deterministic YCSB-style write workload against `rows` rows with the
+// checkpointer enabled, then writes a digest of the final state:
+//
+//   ./recovery_bench run <db_dir> -r <rows> -t <txns> -o <digest_file>
+//
+// Set DORADD_CRASH_POINT (see crash_point.hpp) to kill the run part way
+// through a checkpoint, fold or reclaim. Recovery then rebuilds the rows from
+// the checkpoint, replays the transactions the checkpoint did not cover and
+// compares the final state with a digest from an uncrashed run:
+//
+//   ./recovery_bench recover <db_dir> -r <rows> -t <txns> -c <digest_file>
+//
+// The last line of a recover run is a CSV record for benchmark_recovery.py:
+//   RESULT,rows,txns,recovered_rows,resume_txn,total_ms,scan_ms,decode_ms,
+//          install_ms,replay_ms,verified
+
+#include "ycsb/constants.hpp"
+#include "ycsb/db.hpp"
+#include "SPSCQueue.h"
+#include "hugepage.hpp"
+#include "checkpointer.hpp"
+#include "recovery.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <latch>
+#include <optional>
+#include <thread>
+#include <vector>
+
+struct BenchRow
+{
+  char payload[ROW_SIZE];
+};
+
+struct BenchTransaction
+{
+  using RowType = BenchRow;
+  static Index<BenchRow>* index;
+};
+
+Index<BenchRow>* BenchTransaction::index;
+
+static uint64_t mix(uint64_t x)
+{
+  // splitmix64
+  x += 0x9e3779b97f4a7c15ull;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+  return x ^ (x >> 31);
+}
+
+// Distinct rows written by transaction `txn`
+static void txn_keys(uint64_t txn, uint64_t rows, uint64_t* keys)
+{
+  uint64_t seed = mix(txn);
+  for (uint32_t i = 0; i < ROWS_PER_TX; i++)
+  {
+    uint64_t k;
+    bool dup;
+    do
+    {
+      seed = mix(seed);
+      k = seed % rows;
+      dup = false;
+      for (uint32_t j = 0; j < i; j++)
+        dup |= keys[j] == k;
+    } while (dup);
+    keys[i] = k;
+  }
+}
+
+static void apply(BenchRow* row, uint64_t txn)
+{
+  uint64_t state;
+  memcpy(&state, row->payload, sizeof(state));
+  state = mix(state ^ txn);
+  memset(row->payload + sizeof(state), static_cast<int>(state), WRITE_SIZE);
+  memcpy(row->payload, &state, sizeof(state));
+}
+
+struct Bench
+{
+  uint64_t rows = 100'000;
+  uint64_t txns = 1'000'000;
+  Checkpointer<CheckpointStore, BenchTransaction, BenchRow>* checkpointer;
+  rigtorp::SPSCQueue<int> ring{4};
+  std::atomic<uint64_t> executed{0};
+
+  // Spawns transactions [from, to), checkpointing as the threshold says,
+  // and waits until all of them have executed
+  void spawn(uint64_t from, uint64_t to)
+  {
+    std::vector<uint64_t> dirty;
+    std::vector<bool> seen(rows, false);
+    std::vector<cown_ptr<BenchRow>> cowns(ROWS_PER_TX);
+    std::vector<uint64_t> keys(ROWS_PER_TX);
+
+    for (uint64_t txn = from; txn < to; txn++)
+    {
+      txn_keys(txn, rows, keys.data());
+      for (uint32_t i = 0; i < ROWS_PER_TX; i++)
+      {
+        cowns[i] = BenchTransaction::index->get_row(keys[i]);
+        if (!seen[keys[i]])
+        {
+          seen[keys[i]] = true;
+          dirty.push_back(keys[i]);
+        }
+      }
+      batch_helpers::apply_when<BenchRow>(
+        batch_helpers::cowns_to_tuple<ROWS_PER_TX>(cowns, 0),
+        [this, txn](BenchRow** objs, size_t cnt) {
+          for (size_t i = 0; i < cnt; i++)
+            apply(objs[i], txn);
+          executed.fetch_add(1, std::memory_order_relaxed);
+        });
+
+      checkpointer->increment_tx_count(1);
+      if (checkpointer->should_checkpoint())
+      {
+        checkpointer->schedule_checkpoint(&ring, std::move(dirty));
+        checkpointer->process_checkpoint_request(&ring);
+        seen.assign(rows, false);
+        dirty.clear();
+      }
+    }
+
+    while (executed.load(std::memory_order_relaxed) < to - from)
+      std::this_thread::yield();
+  }
+
+  // Order-independent digest of every row
+  uint64_t digest()
+  {
+    std::atomic<uint64_t> sum{0};
+    std::latch done(rows);
+    for (uint64_t k = 0; k < rows; k++)
+    {
+      when(BenchTransaction::index->get_row(k)) << [&, k](auto&& a) {
+        BenchRow& row = static_cast<BenchRow&>(a);
+        uint64_t state;
+        memcpy(&state, row.payload, sizeof(state));
+        sum.fetch_add(mix(state ^ k), std::memory_order_relaxed);
+        done.count_down();
+      };
+    }
+    done.wait();
+    return sum.load();
+  }
+};
+
+static double ms_since(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double, std::milli>(
+           std::chrono::steady_clock::now() - start)
+    .count();
+}
+
+static int usage()
+{
+  fprintf(
+    stderr,
+    "Usage: ./recovery_bench run|recover <db_dir> [-r rows] [-t txns]"
+    " [-w workers] [-o digest_out] [-c digest_check]"
+    " [checkpointer options]\n");
+  return -1;
+}
+
+int main(int argc, char** argv)
+{
+  if (
+    argc < 3 ||
+    (strcmp(argv[1], "run") != 0 && strcmp(argv[1], "recover") != 0))
+    return usage();
+
+  bool recover = strcmp(argv[1], "recover") == 0;
+  std::string db_dir = argv[2];
+  Bench bench;
+  int workers = 4;
+  const char* digest_out = nullptr;
+  const char* digest_check = nullptr;
+  for (int i = 3; i + 1 < argc; i++)
+  {
+    if (strcmp(argv[i], "-r") == 0)
+      bench.rows = std::stoull(argv[++i]);
+    else if (strcmp(argv[i], "-t") == 0)
+      bench.txns = std::stoull(argv[++i]);
+    else if (strcmp(argv[i], "-w") == 0)
+      workers = atoi(argv[++i]);
+    else if (strcmp(argv[i], "-o") == 0)
+      digest_out = argv[++i];
+    else if (strcmp(argv[i], "-c") == 0)
+      digest_check = argv[++i];
+  }
+  if (bench.rows < ROWS_PER_TX || bench.rows > DB_SIZE)
+  {
+    fprintf(
+      stderr,
+      "-r rows must be between %lu and %lu\n",
+      static_cast<unsigned long>(ROWS_PER_TX),
+      static_cast<unsigned long>(DB_SIZE));
+    return usage();
+  }
+
+  if (!recover)
+    std::filesystem::remove_all(db_dir);
+
+  BenchTransaction::index = new Index<BenchRow>;
+  BenchTransaction::index->attach(
+    aligned_alloc_hpage(Index<BenchRow>::stride() * bench.rows));
+
+  // Rebuild checkpointed rows, then create the rest as a fresh load would
+  std::optional<Recovery<CheckpointStore, BenchRow>> recovery;
+  RecoveryTimings rec_times;
+  uint64_t resume_txn = 0;
+  size_t recovered_rows = 0;
+  if (recover)
+  {
+    recovery.emplace(db_dir);
+    recovered_rows = recovery->recover_into(BenchTransaction::index);
+    rec_times = recovery->timings();
+    resume_txn = recovery->get_total_transactions();
+  }
+  for (uint64_t k = 0; k < bench.rows; k++)
+  {
+    if (recovery && recovery->recovered(k))
+      continue;
+    BenchTransaction::index->install(k, BenchRow{});
+  }
+  recovery.reset();
+
+  bench.checkpointer =
+    new Checkpointer<CheckpointStore, BenchTransaction, BenchRow>(db_dir);
+  bench.checkpointer->parse_args(argc, argv);
+  bench.checkpointer->set_index(BenchTransaction::index);
+
+  auto& sched = Scheduler::get();
+  sched.init(workers + 1);
+
+  double replay_ms = 0;
+  uint64_t digest = 0;
+  when() << [&]() {
+    // Spawn from a separate thread, like the dispatcher pipeline does
+    std::thread driver([&]() {
+      auto start = std::chrono::steady_clock::now();
+      bench.spawn(resume_txn, bench.txns);
+      replay_ms = ms_since(start);
+      digest = bench.digest();
+    });
+    driver.join();
+  };
+  sched.run();
+  delete bench.checkpointer;
+
+  printf("Executed transactions %lu..%lu in %.1f ms, digest %016lx\n",
+         resume_txn, bench.txns, replay_ms, digest);
+
+  if (digest_out)
+    std::ofstream(digest_out) << digest << "\n";
+
+  if (recover)
+  {
+    int verified = -1;
+    if (digest_check)
+    {
+      uint64_t expected = 0;
+      std::ifstream(digest_check) >> expected;
+      verified = expected == digest;
+      printf("Verification: %s\n", verified ? "OK" : "MISMATCH");
+    }
+    printf(
+      "RESULT,%lu,%lu,%zu,%lu,%.1f,%.1f,%.1f,%.1f,%.1f,%d\n",
+      bench.rows,
+      bench.txns,
+      recovered_rows,
+      resume_txn,
+      rec_times.total_ms + replay_ms,
+      rec_times.scan_ms,
+      rec_times.decode_ms,
+      rec_times.install_ms,
+      replay_ms,
+      verified);
+    return verified == 0 ? 1 : 0;
+  }
+  return 0;
+}
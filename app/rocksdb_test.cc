@@ -3,6 +3,11 @@
 #include <rocksdb/options.h>
 #include <rocksdb/slice.h>
 #include <filesystem>
+#include <map>
+#include <mutex>
+#include <thread>
+#include "../src/storage/rocksdb.hpp"
+#include "../src/storage/snapshot_manifest.hpp"
 
 class RocksDBTest : public ::testing::Test {
 protected:
@@ -96,6 +101,158 @@ TEST_F(RocksDBTest, IteratorOperations) {
     EXPECT_EQ(keys[2], "iter_key3");
 }
 
+class RocksDBStoreTest : public ::testing::Test {
+protected:
+    RocksDBStore store;
+    std::string db_path = "/tmp/rocksdb_store_test";
+
+    void SetUp() override {
+        std::filesystem::remove_all(db_path);
+        ASSERT_TRUE(store.open(db_path)) << "Failed to open store";
+    }
+
+    void TearDown() override {
+        store.close();
+        std::filesystem::remove_all(db_path);
+    }
+
+    static std::string key(const char* prefix, int i) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%s%08d", prefix, i);
+        return buf;
+    }
+};
+
+TEST_F(RocksDBStoreTest, IngestSorted) {
+    RocksDBStore::Rows rows;
+    for (int i = 0; i < 10000; i++) rows.emplace_back(key("s/", i), std::to_string(i));
+    ASSERT_TRUE(store.ingest_sorted(rows));
+
+    auto scanned = store.scan_prefix("s/");
+    ASSERT_EQ(scanned.size(), rows.size());
+    EXPECT_EQ(scanned.front(), rows.front());
+    EXPECT_EQ(scanned.back(), rows.back());
+}
+
+TEST_F(RocksDBStoreTest, BulkLoadTakesRangesOutOfOrder) {
+    // Ranges arrive from several threads, last range first
+    auto bulk = store.begin_bulk();
+    std::vector<std::thread> producers;
+    for (int r = 3; r >= 0; r--) {
+        producers.emplace_back([&, r]() {
+            RocksDBStore::Rows rows;
+            for (int i = r * 1000; i < (r + 1) * 1000; i++) rows.emplace_back(key("s/", i), std::to_string(i));
+            bulk->add_range(std::move(rows));
+        });
+    }
+    for (auto& t : producers) t.join();
+    ASSERT_TRUE(bulk->finish());
+
+    std::string value;
+    for (int i = 0; i < 4000; i += 333) {
+        ASSERT_TRUE(store.get(key("s/", i), value));
+        EXPECT_EQ(value, std::to_string(i));
+    }
+    EXPECT_EQ(store.scan_prefix("s/").size(), 4000);
+    EXPECT_TRUE(std::filesystem::is_empty(db_path + "/ingest"));
+}
+
+TEST_F(RocksDBStoreTest, CursorStaysInsidePrefix) {
+    for (int i = 0; i < 100; i++) {
+        store.put(key("s/", i), std::to_string(i));
+        store.put(key("t/", i), "other");
+    }
+    store.put("s", "short");
+
+    int expected = 0;
+    store.for_each_prefix("s/", [&](std::string_view k, std::string_view v) {
+        EXPECT_EQ(k, key("s/", expected));
+        EXPECT_EQ(v, std::to_string(expected));
+        expected++;
+    });
+    EXPECT_EQ(expected, 100);
+
+    size_t n = 0;
+    for (auto c = store.cursor("t/"); c.valid(); c.next()) {
+        EXPECT_EQ(c.value(), "other");
+        n++;
+    }
+    EXPECT_EQ(n, 100);
+    EXPECT_FALSE(store.cursor("u/").valid());
+}
+
+TEST_F(RocksDBStoreTest, ParallelScanVisitsEachRowOnce) {
+    // Row ids run over the whole hex digit range, so split points
+    // interpolated on raw bytes would leave most shards empty
+    static constexpr uint64_t ROWS = 1 << 16;
+    static constexpr size_t PARTS = 4;
+    RocksDBStore::Rows rows;
+    for (uint64_t i = 0; i < ROWS; i++)
+        rows.emplace_back(snapshot_keys::row_key(snapshot_keys::BASE, 1, i), "");
+    ASSERT_TRUE(store.ingest_sorted(rows));
+    store.put(snapshot_keys::row_key(snapshot_keys::BASE, 2, 0), "");
+
+    std::vector<std::atomic<int>> visits(ROWS);
+    std::mutex mu;
+    std::map<std::thread::id, size_t> per_thread;
+    store.parallel_for_each_prefix(snapshot_keys::prefix(snapshot_keys::BASE, 1), PARTS,
+        [&](std::string_view k, std::string_view) {
+            visits[snapshot_keys::row_id(k)]++;
+            std::lock_guard<std::mutex> lock(mu);
+            per_thread[std::this_thread::get_id()]++;
+        });
+
+    for (uint64_t i = 0; i < ROWS; i++) ASSERT_EQ(visits[i].load(), 1) << "row " << i;
+    ASSERT_EQ(per_thread.size(), PARTS);
+    for (auto& [id, n] : per_thread) EXPECT_EQ(n, ROWS / PARTS);
+}
+
+TEST_F(RocksDBStoreTest, DeletePrefixKeepsOtherGroups) {
+    for (const char* group : {"a/", "b/", "c/"}) {
+        RocksDBStore::Rows rows;
+        for (int i = 0; i < 1000; i++) rows.emplace_back(key(group, i), group);
+        ASSERT_TRUE(store.ingest_sorted(rows));
+    }
+    // The first key after "b/" sits alone in a file ending exactly at the
+    // prefix's exclusive upper bound
+    std::string bound = RocksDBStore::prefix_upper_bound("b/");
+    ASSERT_EQ(bound, "b0");
+    ASSERT_TRUE(store.ingest_sorted({{bound, "bound"}}));
+    // "b/" spans its own ingested file, a flushed file and the memtable
+    store.put(key("b/", 1000), "b/");
+    store.flush();
+    store.put(key("b/", 1001), "b/");
+
+    store.delete_prefix("b/");
+
+    std::string value;
+    EXPECT_TRUE(store.scan_prefix("b/").empty());
+    EXPECT_FALSE(store.get(key("b/", 1001), value));
+    EXPECT_EQ(store.scan_prefix("a/").size(), 1000);
+    EXPECT_EQ(store.scan_prefix("c/").size(), 1000);
+    ASSERT_TRUE(store.get(key("c/", 0), value));
+    EXPECT_EQ(value, "c/");
+    ASSERT_TRUE(store.get(bound, value));
+    EXPECT_EQ(value, "bound");
+}
+
+TEST_F(RocksDBStoreTest, ListGroups) {
+    for (int i = 0; i < 100; i++) {
+        store.put(key("i0002/", i), "");
+        store.put(key("b0001/", i), "");
+    }
+    store.put("b0003/x", "");
+    store.put("manifest", "");
+    store.flush();
+
+    std::vector<std::string> expected{"b0001", "b0003", "i0002"};
+    EXPECT_EQ(store.list_groups(), expected);
+
+    store.delete_prefix("b0001/");
+    expected.erase(expected.begin());
+    EXPECT_EQ(store.list_groups(), expected);
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
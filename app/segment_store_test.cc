@@ -0,0 +1,253 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <filesystem>
+#include <thread>
+#include "../src/storage/segment_store.hpp"
+#include "../src/storage/garbage_collector.hpp"
+
+class SegmentStoreTest : public ::testing::Test {
+protected:
+    SegmentStore store;
+    std::string db_path = "/tmp/segment_store_test";
+
+    void SetUp() override {
+        // Clean up any existing database
+        std::filesystem::remove_all(db_path);
+        ASSERT_TRUE(store.open(db_path)) << "Failed to open store";
+    }
+
+    void TearDown() override {
+        store.close();
+        std::filesystem::remove_all(db_path);
+    }
+};
+
+TEST_F(SegmentStoreTest, BatchAndScan) {
+    auto batch = store.create_batch();
+    store.add_to_batch(batch, "s2/b", "value_b");
+    store.add_to_batch(batch, "s2/a", "value_a");
+    store.add_to_batch(batch, "s3/a", "other");
+    store.commit_batch(batch);
+
+    auto rows = store.scan_prefix("s2/");
+    ASSERT_EQ(rows.size(), 2);
+    EXPECT_EQ(rows[0].first, "s2/a");
+    EXPECT_EQ(rows[0].second, "value_a");
+    EXPECT_EQ(rows[1].first, "s2/b");
+
+    std::string value;
+    ASSERT_TRUE(store.get("s3/a", value));
+    EXPECT_EQ(value, "other");
+}
+
+TEST_F(SegmentStoreTest, SpansSegmentsAndSurvivesReopen) {
+    // ~5 segments worth of 1 KB rows
+    std::string row(1000, 'x');
+    for (int i = 0; i < 10000; i += 100) {
+        auto batch = store.create_batch();
+        for (int j = i; j < i + 100; j++) {
+            char key[32];
+            snprintf(key, sizeof(key), "snap/%08d", j);
+            row[0] = 'a' + j % 26;
+            store.add_to_batch(batch, key, row);
+        }
+        store.commit_batch(batch);
+    }
+    auto meta = store.create_batch();
+    store.add_to_batch(meta, "manifest", "base:0;incr:1");
+    store.commit_batch(meta);
+    store.close();
+
+    SegmentStore reopened;
+    ASSERT_TRUE(reopened.open(db_path));
+    std::string value;
+    ASSERT_TRUE(reopened.get("manifest", value));
+    EXPECT_EQ(value, "base:0;incr:1");
+
+    auto rows = reopened.scan_prefix("snap/");
+    ASSERT_EQ(rows.size(), 10000);
+    for (int j = 0; j < 10000; j++) {
+        EXPECT_EQ(rows[j].second.size(), 1000);
+        EXPECT_EQ(rows[j].second[0], 'a' + j % 26);
+    }
+}
+
+TEST_F(SegmentStoreTest, NewestWriteWinsAndDeletePrefix) {
+    store.put("g/k", "old");
+    store.flush();
+    store.put("g/k", "new");
+
+    auto rows = store.scan_prefix("g/");
+    ASSERT_EQ(rows.size(), 1);
+    EXPECT_EQ(rows[0].second, "new");
+
+    store.delete_prefix("g/");
+    EXPECT_TRUE(store.scan_prefix("g/").empty());
+    std::string value;
+    EXPECT_FALSE(store.get("g/k", value));
+}
+
+TEST_F(SegmentStoreTest, LostRowsKeepOldMetadata) {
+    ASSERT_TRUE(store.put("manifest", "v1"));
+
+    // A directory where the next segment of "snap" goes makes its write fail
+    std::filesystem::create_directory(db_path + "/snap.000000.seg");
+    auto batch = store.create_batch();
+    store.add_to_batch(batch, "snap/a", "row");
+    store.add_to_batch(batch, "manifest", "v2");
+    EXPECT_FALSE(store.commit_batch(batch));
+
+    std::string value;
+    ASSERT_TRUE(store.get("manifest", value));
+    EXPECT_EQ(value, "v1");
+
+    // The loss belongs to "snap"; commits that do not write it go through
+    std::filesystem::remove(db_path + "/snap.000000.seg");
+    EXPECT_TRUE(store.put("manifest", "v3"));
+    store.close();
+
+    SegmentStore reopened;
+    ASSERT_TRUE(reopened.open(db_path));
+    ASSERT_TRUE(reopened.get("manifest", value));
+    EXPECT_EQ(value, "v3");
+}
+
+TEST_F(SegmentStoreTest, LostRowsReportedToTheirOwnFlush) {
+    // The first segment of "bad" cannot be created
+    std::filesystem::create_directory(db_path + "/bad.000000.seg");
+    auto batch = store.create_batch();
+    store.add_to_batch(batch, "bad/a", "row");
+    store.commit_batch(batch);
+
+    // Another committer flushes first and sees the write fail, but its own
+    // rows are intact; the failure stays with "bad"
+    batch = store.create_batch();
+    store.add_to_batch(batch, "good/a", "row");
+    store.commit_batch(batch);
+    EXPECT_TRUE(store.flush("good/"));
+    EXPECT_FALSE(store.flush("bad/"));
+    EXPECT_FALSE(store.flush());
+
+    // Both committers flushing concurrently, each after writing its group
+    std::filesystem::create_directory(db_path + "/worse.000000.seg");
+    std::atomic<int> good_ok{0}, worse_ok{0};
+    std::thread worse([&]() {
+        auto b = store.create_batch();
+        store.add_to_batch(b, "worse/a", "row");
+        store.commit_batch(b);
+        for (int i = 0; i < 100; i++) worse_ok += store.flush("worse/");
+    });
+    std::thread good([&]() {
+        for (int i = 0; i < 100; i++) {
+            auto b = store.create_batch();
+            store.add_to_batch(b, "good/" + std::to_string(i), "row");
+            store.commit_batch(b);
+            good_ok += store.flush("good/");
+        }
+    });
+    worse.join();
+    good.join();
+    EXPECT_EQ(worse_ok, 0);
+    EXPECT_EQ(good_ok, 100);
+
+    // Dropping a lost group clears its failure
+    std::filesystem::remove(db_path + "/bad.000000.seg");
+    std::filesystem::remove(db_path + "/worse.000000.seg");
+    store.delete_prefix("bad/");
+    store.delete_prefix("worse/");
+    EXPECT_TRUE(store.flush());
+}
+
+TEST_F(SegmentStoreTest, CursorMergesSegmentsInKeyOrder) {
+    // Interleaved key ranges across several segments, then overwrites that
+    // are partly sealed and partly still in the active segment
+    std::string row(1000, 'x');
+    for (int pass = 0; pass < 2; pass++) {
+        auto batch = store.create_batch();
+        for (int j = pass; j < 6000; j += 2) {
+            char key[32];
+            snprintf(key, sizeof(key), "snap/%08d", j);
+            store.add_to_batch(batch, key, row);
+        }
+        store.commit_batch(batch);
+    }
+    ASSERT_TRUE(store.flush());
+    for (int j : {0, 2999, 5999}) {
+        char key[32];
+        snprintf(key, sizeof(key), "snap/%08d", j);
+        ASSERT_TRUE(store.put(key, "sealed"));
+    }
+    ASSERT_TRUE(store.put("snap/00000001", "active"));
+    ASSERT_TRUE(store.put("snapshot/a", "other group"));
+    store.put("snap/00000002", "newest");
+
+    auto expected = store.scan_prefix("snap/");
+    ASSERT_EQ(expected.size(), 6000);
+    size_t n = 0;
+    for (auto c = store.cursor("snap/"); c.valid(); c.next(), n++) {
+        ASSERT_LT(n, expected.size());
+        ASSERT_EQ(c.key(), expected[n].first);
+        ASSERT_EQ(c.value(), expected[n].second);
+    }
+    EXPECT_EQ(n, expected.size());
+    EXPECT_EQ(expected[0].second, "sealed");
+    EXPECT_EQ(expected[1].second, "active");
+    EXPECT_EQ(expected[2].second, "newest");
+
+    n = 0;
+    store.for_each_prefix("snapshot/", [&](std::string_view k, std::string_view v) {
+        EXPECT_EQ(k, "snapshot/a");
+        EXPECT_EQ(v, "other group");
+        n++;
+    });
+    EXPECT_EQ(n, 1);
+    EXPECT_FALSE(store.cursor("none/").valid());
+}
+
+TEST_F(SegmentStoreTest, ParallelScanVisitsEveryRowOnce) {
+    std::string row(1000, 'x');
+    auto batch = store.create_batch();
+    for (int j = 0; j < 5000; j++) {
+        char key[32];
+        snprintf(key, sizeof(key), "snap/%08d", j);
+        store.add_to_batch(batch, key, row);
+    }
+    store.add_to_batch(batch, "other/a", row);
+    store.commit_batch(batch);
+
+    std::vector<std::atomic<int>> seen(5000);
+    std::atomic<size_t> visited{0};
+    store.parallel_for_each_prefix("snap/", 4, [&](std::string_view k, std::string_view v) {
+        EXPECT_EQ(v.size(), 1000);
+        seen[std::stoi(std::string(k.substr(5)))]++;
+        visited++;
+    });
+    EXPECT_EQ(visited.load(), 5000);
+    for (auto& s : seen) EXPECT_EQ(s.load(), 1);
+}
+
+TEST_F(SegmentStoreTest, GarbageCollectorDropsOrphanedSnapshots) {
+    auto batch = store.create_batch();
+    for (uint64_t snap : {1, 2, 3})
+        store.add_to_batch(batch, snapshot_keys::row_key(snapshot_keys::INCREMENTAL, snap, 7), "row");
+    store.add_to_batch(batch, snapshot_keys::row_key(snapshot_keys::BASE, 2, 7), "row");
+    store.commit_batch(batch);
+
+    // Base 2 plus incremental 3 are live; incremental 1 was folded and
+    // incremental 2 is referenced only through the base.
+    SnapshotManifest live;
+    live.base = 2;
+    live.incrementals = {3};
+    GarbageCollector<SegmentStore> gc(store);
+    EXPECT_EQ(gc.collect_orphans(live), 2);
+
+    auto groups = store.list_groups();
+    ASSERT_EQ(groups.size(), 2);
+    EXPECT_EQ(groups[0] + "/", snapshot_keys::prefix(snapshot_keys::BASE, 2));
+    EXPECT_EQ(groups[1] + "/", snapshot_keys::prefix(snapshot_keys::INCREMENTAL, 3));
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
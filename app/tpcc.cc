@@ -29,9 +29,7 @@ using namespace verona::cpp;
     _ol##_INDEX.ol_quantity = txm->params[35 + (_INDEX - 1)]; \
     _ol##_INDEX.ol_amount = _i##_INDEX->i_price * txm->params[35 + (_INDEX - 1)]; \
     amount += _ol##_INDEX.ol_amount; \
-    uint64_t _ol_hash_key##_INDEX = _ol##_INDEX.hash_key(); \
-    cown_ptr<OrderLine> _ol_cown##_INDEX = make_cown<OrderLine>(_ol##_INDEX); \
-    index->order_line_table.insert_row(_ol_hash_key##_INDEX, _ol_cown##_INDEX); \
+    index->order_line_table.insert(_ol##_INDEX.hash_key(), _ol##_INDEX); \
   }
 
 #define UPDATE_STOCK_AND_INSERT_ORDER_LINE(_INDEX) \
@@ -96,6 +94,7 @@ public:
 #endif
   // static Index<YCSBRow>* index;
   static Database* index;
+  static constexpr size_t MarshalledSize = sizeof(TPCCTransactionMarshalled);
 
 #if defined(INDEXER) || defined(TEST_TWO)
   // Indexer: read db and in-place update cown_ptr
@@ -110,46 +109,43 @@ public:
     {
       // Warehouse
       // txm->cown_ptrs[0] =
-      //   index->warehouse_table.get_row_addr(txm->params[0])->get_base_addr();
-      txm->cown_ptrs[0] = index->warehouse_table.get_row_addr(Warehouse::hash_key(txm->params[0]))->get_base_addr();
+      //   index->warehouse_table.get_base_addr(txm->params[0]);
+      txm->cown_ptrs[0] = index->warehouse_table.get_base_addr(Warehouse::hash_key(txm->params[0]));
 
       // // District
       txm->cown_ptrs[1] =
-        index->district_table.get_row_addr(District::hash_key(txm->params[0], txm->params[1]))->get_base_addr();
+        index->district_table.get_base_addr(District::hash_key(txm->params[0], txm->params[1]));
 
       // // Customer
       txm->cown_ptrs[2] =
-        index->customer_table.get_row_addr(Customer::hash_key(txm->params[0], txm->params[1], txm->params[2]))
-          ->get_base_addr();
+        index->customer_table.get_base_addr(Customer::hash_key(txm->params[0], txm->params[1], txm->params[2]));
 
       // Stock
       for (int i = 0; i < txm->params[50]; i++)
       {
         txm->cown_ptrs[3 + i] =
           index->stock_table
-            .get_row_addr(Stock::hash_key(txm->params[20 + i], txm->params[5 + i])) // i_w_id, i_id
-            ->get_base_addr();
+            .get_base_addr(Stock::hash_key(txm->params[20 + i], txm->params[5 + i])); // i_w_id, i_id
       }
 
       // Item
       for (int i = 0; i < txm->params[50]; i++)
       {
-        txm->cown_ptrs[18 + i] = index->item_table.get_row_addr(Item::hash_key(txm->params[5 + i]))->get_base_addr();
+        txm->cown_ptrs[18 + i] = index->item_table.get_base_addr(Item::hash_key(txm->params[5 + i]));
       }
     }
     else if (txm->txn_type == 1)
     {
       // Warehouse
-      txm->cown_ptrs[0] = index->warehouse_table.get_row_addr(Warehouse::hash_key(txm->params[0]))->get_base_addr();
+      txm->cown_ptrs[0] = index->warehouse_table.get_base_addr(Warehouse::hash_key(txm->params[0]));
 
       // District
       txm->cown_ptrs[1] =
-        index->district_table.get_row_addr(District::hash_key(txm->params[0], txm->params[1]))->get_base_addr();
+        index->district_table.get_base_addr(District::hash_key(txm->params[0], txm->params[1]));
 
       // Customer
       txm->cown_ptrs[2] =
-        index->customer_table.get_row_addr(Customer::hash_key(txm->params[0], txm->params[1], txm->params[2]))
-          ->get_base_addr();
+        index->customer_table.get_base_addr(Customer::hash_key(txm->params[0], txm->params[1], txm->params[2]));
     }
 
     return sizeof(TPCCTransactionMarshalled);
@@ -169,26 +165,22 @@ public:
 #ifdef LOG_LATENCY
 #define NEWORDER_END() \
   { \
-    cown_ptr<Order> o_cown = make_cown<Order>(o); \
-    cown_ptr<NewOrder> no_cown = make_cown<NewOrder>(no); \
-    index->order_table.insert_row(order_hash_key, std::move(o_cown)); \
-    index->new_order_table.insert_row(neworder_hash_key, std::move(no_cown)); \
+    index->order_table.insert(order_hash_key, o); \
+    index->new_order_table.insert(neworder_hash_key, no); \
     TxCounter::instance().incr(); \
     TxCounter::instance().log_latency(init_time); \
   }
 #else
 #define NEWORDER_END() \
   { \
-    cown_ptr<Order> o_cown = make_cown<Order>(o); \
-    cown_ptr<NewOrder> no_cown = make_cown<NewOrder>(no); \
-    index->order_table.insert_row(order_hash_key, std::move(o_cown)); \
-    index->new_order_table.insert_row(neworder_hash_key, std::move(no_cown)); \
+    index->order_table.insert(order_hash_key, o); \
+    index->new_order_table.insert(neworder_hash_key, no); \
     TxCounter::instance().incr(); \
   }
 #endif
 
 #ifdef RPC_LATENCY
-  static int parse_and_process(const char* input, ts_type init_time)
+  static int parse_and_process(const char* input, uint64_t init_time)
 #else
   static int parse_and_process(const char* input)
 #endif // RPC_LATENCY
@@ -236,7 +228,8 @@ public:
       cown_ptr<Customer> c = get_cown_ptr_from_addr<Customer>(reinterpret_cast<void*>(txm->cown_ptrs[2]));
       uint32_t h_amount = txm->params[52];
 
-      WHEN(d, c) << [=]PARAMS(auto _d, auto _c) {
+      WHEN(d, c) << [= TXN_TRACE_CAPTURE]PARAMS(auto _d, auto _c) {
+        TXN_TRACE_BEGIN();
         WAREHOUSE_OP();
         // Update district balance
         _d->d_ytd += h_amount;
@@ -250,6 +243,7 @@ public:
         TxCounter::instance().log_latency(init_time);
 #endif
        TxCounter::instance().incr();
+        TXN_TRACE_END();
       };
     }
 
@@ -264,11 +258,14 @@ Database* TPCCTransaction::index;
 
 int main(int argc, char** argv)
 {
-  if (argc != 6 || strcmp(argv[1], "-n") != 0)
+  if (argc < 6 || strcmp(argv[1], "-n") != 0)
   {
     fprintf(stderr,
             "Usage: ./program -n core_cnt"
-            " <dispatcher_input_file> -i <inter_arrival>\n");
+            " <dispatcher_input_file> -i <inter_arrival>"
+            " [--sweep <Mreq/s>,... [--warmup <s>] [--measure <s>]]"
+            " [--numa <policy>] [--numa-workers <node>]"
+            " [--hugepages thp|2m|1g|<hugetlbfs dir>] [--load-threads <n>]\n");
     return -1;
   }
 
@@ -279,49 +276,51 @@ int main(int argc, char** argv)
   char* gen_file = argv[5];
 
   // Create rows (cowns) with huge pages and via static allocation
+  numa::Config::instance().parse_args(argc, argv);
+  hpage::Config::instance().parse_args(argc, argv);
+  populate::Config::instance().parse_args(argc, argv);
   TPCCTransaction::index = new Database();
 
+  // Bytes per table: its row slot stride times its rows. Orders, order
+  // lines and new orders are InsertTables that grow as transactions run.
+  const size_t sz_warehouse = WarehouseTable::stride() * TSIZE_WAREHOUSE;
+  const size_t sz_district = DistrictTable::stride() * TSIZE_DISTRICT;
+  const size_t sz_customer = CustomerTable::stride() * TSIZE_CUSTOMER;
+  const size_t sz_stock = StockTable::stride() * TSIZE_STOCK;
+  const size_t sz_item = ItemTable::stride() * TSIZE_ITEM;
+  const size_t sz_history = HistoryTable::stride() * TSIZE_HISTORY;
+
 #ifdef SINGLE_TABLE
   // Big table to store all tpcc related stuff
   void* tpcc_arr_addr_warehouse = static_cast<void*>(
-    aligned_alloc_hpage(1024 * (TSIZE_WAREHOUSE + TSIZE_DISTRICT + (2 * TSIZE_CUSTOMER) + TSIZE_STOCK + TSIZE_ITEM +
-                                TSIZE_HISTORY + TSIZE_ORDER + TSIZE_ORDER_LINE + TSIZE_NEW_ORDER))
+    numa::alloc_arena(sz_warehouse + sz_district + sz_customer + sz_stock + sz_item +
+                      sz_history)
   );
   
-  void* tpcc_arr_addr_district = static_cast<void*>(static_cast<char*>(tpcc_arr_addr_warehouse) + 1024 * TSIZE_WAREHOUSE);
-  void* tpcc_arr_addr_customer = static_cast<void*>(static_cast<char*>(tpcc_arr_addr_district) + 1024 * TSIZE_DISTRICT);
-  void* tpcc_arr_addr_stock = static_cast<void*>(static_cast<char*>(tpcc_arr_addr_customer) + 2 * 1024 * TSIZE_CUSTOMER);
-  void* tpcc_arr_addr_item = static_cast<void*>(static_cast<char*>(tpcc_arr_addr_stock) + 1024 * TSIZE_STOCK);
-  void* tpcc_arr_addr_history = static_cast<void*>(static_cast<char*>(tpcc_arr_addr_item) + 1024 * TSIZE_ITEM);
-  void* tpcc_arr_addr_order = static_cast<void*>(static_cast<char*>(tpcc_arr_addr_history) + 1024 * TSIZE_HISTORY);
-  void* tpcc_arr_addr_order_line = static_cast<void*>(static_cast<char*>(tpcc_arr_addr_order) + 1024 * TSIZE_ORDER);
-  void* tpcc_arr_addr_new_order = static_cast<void*>(static_cast<char*>(tpcc_arr_addr_order_line) + 1024 * TSIZE_ORDER_LINE);
+  void* tpcc_arr_addr_district = static_cast<void*>(static_cast<char*>(tpcc_arr_addr_warehouse) + sz_warehouse);
+  void* tpcc_arr_addr_customer = static_cast<void*>(static_cast<char*>(tpcc_arr_addr_district) + sz_district);
+  void* tpcc_arr_addr_stock = static_cast<void*>(static_cast<char*>(tpcc_arr_addr_customer) + sz_customer);
+  void* tpcc_arr_addr_item = static_cast<void*>(static_cast<char*>(tpcc_arr_addr_stock) + sz_stock);
+  void* tpcc_arr_addr_history = static_cast<void*>(static_cast<char*>(tpcc_arr_addr_item) + sz_item);
   
 #else
   // Big table to store all tpcc related stuff
-  void* tpcc_arr_addr_warehouse = static_cast<void*>(aligned_alloc_hpage(1024 * TSIZE_WAREHOUSE));
-  void* tpcc_arr_addr_district = static_cast<void*>(aligned_alloc_hpage(1024 * TSIZE_DISTRICT));
-  void* tpcc_arr_addr_customer = static_cast<void*>(aligned_alloc_hpage(2 * 1024 * TSIZE_CUSTOMER));
-  void* tpcc_arr_addr_stock = static_cast<void*>(aligned_alloc_hpage(1024 * TSIZE_STOCK));
-  void* tpcc_arr_addr_item = static_cast<void*>(aligned_alloc_hpage(1024 * TSIZE_ITEM));
-  void* tpcc_arr_addr_history = static_cast<void*>(aligned_alloc_hpage(1024 * TSIZE_HISTORY));
-  void* tpcc_arr_addr_order = static_cast<void*>(aligned_alloc_hpage(1024 * TSIZE_ORDER));
-  void* tpcc_arr_addr_order_line = static_cast<void*>(aligned_alloc_hpage(1024 * TSIZE_ORDER_LINE));
-  void* tpcc_arr_addr_new_order = static_cast<void*>(aligned_alloc_hpage(1024 * TSIZE_NEW_ORDER));
+  void* tpcc_arr_addr_warehouse = static_cast<void*>(numa::alloc_arena(sz_warehouse));
+  void* tpcc_arr_addr_district = static_cast<void*>(numa::alloc_arena(sz_district));
+  void* tpcc_arr_addr_customer = static_cast<void*>(numa::alloc_arena(sz_customer));
+  void* tpcc_arr_addr_stock = static_cast<void*>(numa::alloc_arena(sz_stock));
+  void* tpcc_arr_addr_item = static_cast<void*>(numa::alloc_arena(sz_item));
+  void* tpcc_arr_addr_history = static_cast<void*>(numa::alloc_arena(sz_history));
 #endif
 
-  TPCCGenerator gen(TPCCTransaction::index, tpcc_arr_addr_warehouse, tpcc_arr_addr_district, tpcc_arr_addr_customer,
-  tpcc_arr_addr_stock, tpcc_arr_addr_item, tpcc_arr_addr_history, tpcc_arr_addr_order, tpcc_arr_addr_order_line, tpcc_arr_addr_new_order);
+  TPCCTransaction::index->warehouse_table.attach(tpcc_arr_addr_warehouse);
+  TPCCTransaction::index->district_table.attach(tpcc_arr_addr_district);
+  TPCCTransaction::index->customer_table.attach(tpcc_arr_addr_customer);
+  TPCCTransaction::index->stock_table.attach(tpcc_arr_addr_stock);
+  TPCCTransaction::index->item_table.attach(tpcc_arr_addr_item);
+  TPCCTransaction::index->history_table.attach(tpcc_arr_addr_history);
 
-  TPCCTransaction::index->warehouse_table.start_addr = (void*)tpcc_arr_addr_warehouse;
-  TPCCTransaction::index->district_table.start_addr = (void*)tpcc_arr_addr_district;
-  TPCCTransaction::index->customer_table.start_addr = (void*)tpcc_arr_addr_customer;
-  TPCCTransaction::index->stock_table.start_addr = (void*)tpcc_arr_addr_stock;
-  TPCCTransaction::index->item_table.start_addr = (void*)tpcc_arr_addr_item;
-  TPCCTransaction::index->history_table.start_addr = (void*)tpcc_arr_addr_history;
-  TPCCTransaction::index->order_table.start_addr = (void*)tpcc_arr_addr_order;
-  TPCCTransaction::index->order_line_table.start_addr = (void*)tpcc_arr_addr_order_line;
-  TPCCTransaction::index->new_order_table.start_addr = (void*)tpcc_arr_addr_new_order;
+  TPCCGenerator gen(TPCCTransaction::index);
 
   gen.generateWarehouses();
   gen.generateDistricts();
@@ -330,7 +329,8 @@ int main(int argc, char** argv)
   gen.generateStocks();
   gen.generateOrdersAndOrderLines();
 
-  build_pipelines<TPCCTransaction>(core_cnt - 1, input_file, gen_file);
+  build_pipelines<TPCCTransaction>(
+    core_cnt - 1, input_file, gen_file, argc, argv);
 
   // Cleanup
   delete TPCCTransaction::index;
@@ -33,7 +33,7 @@ public:
   {
     return wid - 1;
   }
-} __attribute__((aligned(256)));
+};
 
 class __attribute__((packed)) District
 {
@@ -64,7 +64,7 @@ public:
     return ((wid - 1) * DISTRICTS_PER_WAREHOUSE) + (did - 1);
   }
 
-} __attribute__((aligned(256)));
+};
 
 class __attribute__((packed)) Item
 {
@@ -88,7 +88,7 @@ public:
     return iid - 1;
   }
 
-} __attribute__((aligned(128)));
+};
 
 class __attribute__((packed)) Customer
 {
@@ -129,7 +129,7 @@ public:
       (cid - 1);
   }
 
-} __attribute__((aligned(1024)));
+};
 
 // Primary Key: (O_W_ID, O_D_ID, O_ID)
 class __attribute__((packed)) Order
@@ -158,7 +158,7 @@ public:
       ((did - 1) * (INITIAL_ORDERS_PER_DISTRICT + MAX_ORDER_TRANSACTIONS)) + (oid - 1);
   }
 
-} __attribute__((aligned(64)));
+};
 
 // Order line means
 class __attribute__((packed)) OrderLine
@@ -190,7 +190,7 @@ public:
     return (Order::hash_key(wid, did, oid) * 15) + (number - 1);
   }
 
-} __attribute__((aligned(256)));
+};
 
 class __attribute__((packed)) NewOrder
 {
@@ -213,7 +213,7 @@ public:
       ((did - 1) * (INITIAL_ORDERS_PER_DISTRICT + MAX_ORDER_TRANSACTIONS)) + (oid - 1);
   }
 
-} __attribute__((aligned(32)));
+};
 
 class Stock
 {
@@ -250,7 +250,7 @@ public:
     return ((wid - 1) * STOCK_PER_WAREHOUSE) + (iid - 1);
   }
 
-} __attribute__((aligned(512)));
+};
 
 class __attribute__((packed)) History
 {
@@ -285,4 +285,4 @@ public:
       (cid - 1);
   }
 
-} __attribute__((aligned(128)));
+};
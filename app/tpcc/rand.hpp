@@ -12,9 +12,17 @@ class Rand {
     bool oc_init = false;
     std::vector<int> oc_id_vector;
     FastRandom r;
+    uint32_t clock = 100000;
+
+    // Fisher-Yates on our own stream, so the order depends only on the seed
+    template <typename T>
+    void shuffle(std::vector<T>& v) {
+        for (size_t i = v.size(); i > 1; i--) std::swap(v[i - 1], v[randomNumber(0, i - 1)]);
+    }
 
    public:
     Rand() : r(0xdeadbeef) {}
+    explicit Rand(unsigned long seed) : r(seed) {}
 
     int checkBetweenInclusive(int v, int lower, int upper) {
         assert(v >= lower);
@@ -43,7 +51,7 @@ class Rand {
         if (!oc_init) {
             oc_init = true;
             for (int i = 0; i < 3000; i++) oc_id_vector.push_back(i);
-            std::random_shuffle(oc_id_vector.begin(), oc_id_vector.end());
+            shuffle(oc_id_vector);
         }
         int ret = oc_id_vector.back();
         oc_id_vector.pop_back();
@@ -54,13 +62,12 @@ class Rand {
 
         std::vector<uint32_t> ret;
         for (int i = min; i <= max; i++) ret.push_back(i);
-        std::random_shuffle(ret.begin(), ret.end());
+        shuffle(ret);
         return ret;
     }
 
     uint32_t GetCurrentTime() {
-        static __thread uint32_t tl_hack = 100000;
-        return ++tl_hack;
+        return ++clock;
     }
 
     std::string generateRandomString(int length) {
@@ -11,57 +11,21 @@
 #include <atomic>
 
 #include "entries.hpp"
+#include "insert_table.hpp"
+#include "stride_table.hpp"
 
 using namespace verona::rt;
 using namespace verona::cpp;
 
 
-template<typename Key, typename T, uint64_t DB_SIZE>
-struct Table
-{
-private:
-  std::array<cown_ptr<T>, DB_SIZE> map;
-  uint64_t cnt = 0;
-
-public:
-  void * start_addr = 0;
-
-  Table() : map(std::array<cown_ptr<T>, DB_SIZE>()) {}
-
-  cown_ptr<T>* get_row_addr(uint64_t key)
-  {
-    return &map[key];
-  }
-
-  cown_ptr<T>&& get_row(uint64_t key)
-  {
-    return std::move(map[key]);
-  }
-
-  uint64_t insert_row(Key key, cown_ptr<T> r)
-  {
-    if (cnt < DB_SIZE)
-    {
-        map[key] = r;
-        return cnt++;
-    }
-    else
-    {
-      //printf("DB is %lu\n", DB_SIZE);
-      throw std::out_of_range("Index is full");
-    }
-  }
-};
-
-
 // ========================
 // === WAREHOUSE TABLE ====
 // primary key: w_id
 // ========================
 
-class WarehouseTable : public Table<uint64_t, Warehouse, TSIZE_WAREHOUSE> {
+class WarehouseTable : public StrideTable<Warehouse> {
    public:
-     WarehouseTable() : Table<uint64_t, Warehouse, TSIZE_WAREHOUSE> () {
+     WarehouseTable() {
        printf("Warehouse tbl size: %lu\n", TSIZE_WAREHOUSE);
      }
 };
@@ -71,10 +35,10 @@ class WarehouseTable : public Table<uint64_t, Warehouse, TSIZE_WAREHOUSE> {
 // primary key: (w_id, d_id)
 // =======================
 
-class DistrictTable : public Table<uint64_t, District, TSIZE_DISTRICT> {
+class DistrictTable : public StrideTable<District> {
    public:
     std::atomic<uint32_t> order_id = 0;
-    DistrictTable() : Table<uint64_t, District, TSIZE_DISTRICT> () {
+    DistrictTable() {
     printf("District tbl size: %lu\n", TSIZE_DISTRICT);
     }
 };
@@ -84,9 +48,9 @@ class DistrictTable : public Table<uint64_t, District, TSIZE_DISTRICT> {
 // primary key: i_id
 // =======================
 
-class ItemTable : public Table<uint64_t, Item, TSIZE_ITEM> {
+class ItemTable : public StrideTable<Item> {
    public:
-     ItemTable() : Table<uint64_t, Item, TSIZE_ITEM> () {
+     ItemTable() {
     printf("Item tbl size: %lu\n", TSIZE_ITEM);
      }
 };
@@ -96,9 +60,9 @@ class ItemTable : public Table<uint64_t, Item, TSIZE_ITEM> {
 // primary key: (w_id, d_id, c_id)
 // =======================
 
-class CustomerTable : public Table<uint64_t, Customer, TSIZE_CUSTOMER> {
+class CustomerTable : public StrideTable<Customer> {
    public:
-     CustomerTable() : Table<uint64_t, Customer, TSIZE_CUSTOMER> () {
+     CustomerTable() {
     printf("Customer tbl size: %lu\n", TSIZE_CUSTOMER);
      }
 };
@@ -109,9 +73,9 @@ class CustomerTable : public Table<uint64_t, Customer, TSIZE_CUSTOMER> {
 // desc: individual items of each order
 // ===================
 
-class OrderLineTable : public Table<uint64_t, OrderLine, TSIZE_ORDER_LINE> {
+class OrderLineTable : public InsertTable<OrderLine> {
    public:
-     OrderLineTable() : Table<uint64_t, OrderLine, TSIZE_ORDER_LINE> () {
+     OrderLineTable() : InsertTable<OrderLine>(TSIZE_ORDER_LINE) {
     printf("OrderLine tbl size: %lu\n", TSIZE_ORDER_LINE);
      }
 };
@@ -121,9 +85,9 @@ class OrderLineTable : public Table<uint64_t, OrderLine, TSIZE_ORDER_LINE> {
 // primary key: (w_id, i_id)
 // ====================
 
-class StockTable : public Table<uint64_t, Stock, TSIZE_STOCK> {
+class StockTable : public StrideTable<Stock> {
    public:
-     StockTable() : Table<uint64_t, Stock, TSIZE_STOCK> () {
+     StockTable() {
       printf("Stock tbl size: %lu\n", TSIZE_STOCK);
      }
 };
@@ -134,9 +98,9 @@ class StockTable : public Table<uint64_t, Stock, TSIZE_STOCK> {
 // desc: orders placed
 // ====================
 
-class OrderTable : public Table<uint64_t, Order, TSIZE_ORDER> {
+class OrderTable : public InsertTable<Order> {
    public:
-     OrderTable() : Table<uint64_t, Order, TSIZE_ORDER> () {
+     OrderTable() : InsertTable<Order>(TSIZE_ORDER) {
 
       printf("Order tbl size: %lu\n", TSIZE_ORDER);
      }
@@ -148,9 +112,9 @@ class OrderTable : public Table<uint64_t, Order, TSIZE_ORDER> {
 // desc: new orders
 // ====================
 
-class NewOrderTable : public Table<uint64_t, NewOrder, TSIZE_NEW_ORDER> {
+class NewOrderTable : public InsertTable<NewOrder> {
    public:
-     NewOrderTable() : Table<uint64_t, NewOrder, TSIZE_NEW_ORDER> () {
+     NewOrderTable() : InsertTable<NewOrder>(TSIZE_NEW_ORDER) {
       printf("New Order tbl size: %lu\n", TSIZE_NEW_ORDER);
      }
 };
@@ -161,9 +125,9 @@ class NewOrderTable : public Table<uint64_t, NewOrder, TSIZE_NEW_ORDER> {
 // desc: history of payments
 // ====================
 
-class HistoryTable : public Table<uint64_t, History, TSIZE_HISTORY> {
+class HistoryTable : public StrideTable<History> {
    public:
-     HistoryTable() : Table<uint64_t, History, TSIZE_HISTORY> () {
+     HistoryTable() {
       printf("History tbl size: %lu\n", TSIZE_HISTORY);
      }
 };
@@ -31,7 +31,8 @@ define(`LAMBDA_PARAMS', `ifelse(`$1', 0, `auto _d, auto _c',
 define(`__NEW_ORDER_CASE', `
   {
   GET_COWN_PTRS($1)
-  WHEN(WHEN_PARAMS($1)) << [=]PARAMS(LAMBDA_PARAMS($1)) {
+  WHEN(WHEN_PARAMS($1)) << [= TXN_TRACE_CAPTURE]PARAMS(LAMBDA_PARAMS($1)) {
+    TXN_TRACE_BEGIN();
     WAREHOUSE_OP();
     Order o = Order(txm->params[0], txm->params[1], _d->d_next_o_id);
     NewOrder no = NewOrder(txm->params[0], txm->params[1], _d->d_next_o_id);
@@ -41,6 +42,7 @@ define(`__NEW_ORDER_CASE', `
     uint32_t amount = 0;
     UPDATE_STOCK_AND_OL$1();
     NEWORDER_END();
+    TXN_TRACE_END();
   };
   break;
 }')
@@ -1,8 +1,11 @@
 #include "ycsb/constants.hpp"
 #include "ycsb/db.hpp"
 #include "pipeline.hpp"
+#include "populate.hpp"
 #include "txcounter.hpp"
+#include "recovery.hpp"
 
+#include <optional>
 #include <thread>
 
 #define GET_COWN(_INDEX) \
@@ -54,6 +57,7 @@ public:
     uint8_t pad[2];
   } Marshalled;
   // static_assert(sizeof(YCSBTransactionMarshalled) == 128);
+  static constexpr size_t MarshalledSize = sizeof(Marshalled);
 
   static int prepare_cowns(char* input)
   {
@@ -66,8 +70,7 @@ public:
         std::cout << "Index out of bounds: " << txm->indices[i] << std::endl;
         exit(1);
       }
-      auto&& cown = index->get_row(txm->indices[i]);
-      txm->cown_ptrs[i] = cown.get_base_addr();
+      txm->cown_ptrs[i] = index->get_base_addr(txm->indices[i]);
     }
 
     txm->indices_size = ROWS_PER_TX;
@@ -86,7 +89,7 @@ public:
   }
 
 #ifdef RPC_LATENCY
-  static int parse_and_process(const char* input, ts_type init_time)
+  static int parse_and_process(const char* input, uint64_t init_time)
 #else
   static int parse_and_process(const char* input)
 #endif // RPC_LATENCY
@@ -123,9 +126,10 @@ public:
     using AcqType = acquired_cown<YCSBRow>;
 #ifdef RPC_LATENCY
     when(row0, row1, row2, row3, row4, row5, row6, row7, row8, row9)
-      << [ws_cap, init_time]
+      << [ws_cap, init_time TXN_TRACE_CAPTURE]
 #else
-    when(row0, row1, row2, row3, row4, row5, row6, row7, row8, row9) << [ws_cap]
+    when(row0, row1, row2, row3, row4, row5, row6, row7, row8, row9)
+      << [ws_cap TXN_TRACE_CAPTURE]
 #endif
       (AcqType acq_row0,
        AcqType acq_row1,
@@ -137,6 +141,7 @@ public:
        AcqType acq_row7,
        AcqType acq_row8,
        AcqType acq_row9) {
+        TXN_TRACE_BEGIN();
         uint8_t sum = 0;
         uint16_t write_set_l = ws_cap;
         int j;
@@ -151,6 +156,7 @@ public:
         TXN(8);
         TXN(9);
         M_LOG_LATENCY();
+        TXN_TRACE_END();
       };
     return sizeof(Marshalled);
   }
@@ -162,38 +168,58 @@ Index<YCSBRow>* YCSBTransaction::index;
 
 int main(int argc, char** argv)
 {
-  if (argc != 6 || strcmp(argv[1], "-n") != 0)
+  if (argc < 6 || strcmp(argv[1], "-n") != 0)
   {
     fprintf(
       stderr,
       "Usage: ./program -n core_cnt"
-      " <dispatcher_input_file> -i <inter_arrival>\n");
+      " <dispatcher_input_file> -i <inter_arrival> [--recover]"
+      " [--sweep <Mreq/s>,... [--warmup <s>] [--measure <s>]]"
+      " [--numa <policy>] [--numa-workers <node>]"
+      " [--hugepages thp|2m|1g|<hugetlbfs dir>] [--load-threads <n>]\n");
     return -1;
   }
 
+  bool recover = false;
+  for (int i = 6; i < argc; i++)
+    if (strcmp(argv[i], "--recover") == 0)
+      recover = true;
+
   uint8_t core_cnt = atoi(argv[2]);
   uint8_t max_core = std::thread::hardware_concurrency();
   assert(1 < core_cnt && core_cnt <= max_core);
 
   // Create rows (cowns) with huge pages and via static allocation
+  numa::Config::instance().parse_args(argc, argv);
+  hpage::Config::instance().parse_args(argc, argv);
+  populate::Config::instance().parse_args(argc, argv);
   YCSBTransaction::index = new Index<YCSBRow>;
-  uint64_t cown_prev_addr = 0;
-  uint8_t* cown_arr_addr =
-    static_cast<uint8_t*>(aligned_alloc_hpage(1024 * DB_SIZE));
+  YCSBTransaction::index->attach(
+    numa::alloc_arena(Index<YCSBRow>::stride() * DB_SIZE));
 
-  for (int i = 0; i < DB_SIZE; i++)
+  // Rebuild checkpointed rows in place first; the loop below only creates
+  // the rows the checkpoint did not cover
+  std::optional<Recovery<CheckpointStore, YCSBRow>> recovery;
+  if (recover)
   {
-    cown_ptr<YCSBRow> cown_r = make_cown_custom<YCSBRow>(
-      reinterpret_cast<void*>(cown_arr_addr + (uint64_t)1024 * i));
-
-    if (i > 0)
-      assert((cown_r.get_base_addr() - cown_prev_addr) == 1024);
-    cown_prev_addr = cown_r.get_base_addr();
-
-    YCSBTransaction::index->insert_row(cown_r);
+    recovery.emplace(checkpoint_db_path);
+    recovery->recover_into(YCSBTransaction::index);
   }
 
-  
+  populate::parallel_for(
+    "ycsb rows", 0, DB_SIZE, 4096, [&](uint64_t lo, uint64_t hi) {
+      uint64_t rows = 0;
+      for (uint64_t i = lo; i < hi; i++)
+      {
+        if (recovery && recovery->recovered(i))
+          continue;
+        YCSBTransaction::index->install(i);
+        rows++;
+      }
+      return rows;
+    });
+  // Close the recovery store before the checkpointer reopens it
+  recovery.reset();
 
-  build_pipelines<YCSBTransaction>(core_cnt - 1, argv[3], argv[5]);
+  build_pipelines<YCSBTransaction>(core_cnt - 1, argv[3], argv[5], argc, argv);
 }
@@ -1,42 +1,19 @@
 #pragma once
 
 #include "constants.hpp"
+#include "stride_table.hpp"
 
 #include <cpp/when.h>
 
 using namespace verona::rt;
 using namespace verona::cpp;
 
+// Rows live at arena + row_stride<T>() * key (see stride_table.hpp)
 template<typename T>
-struct Index
+struct Index : public StrideTable<T>
 {
-private:
-  std::array<cown_ptr<T>, DB_SIZE> map;
-  uint64_t cnt = 0;
-
-public:
-  Index() : map(std::array<cown_ptr<T>, DB_SIZE>()) {}
-
-  cown_ptr<T>* get_row_addr(uint64_t key)
-  {
-    return &map[key];
-  }
-
-  cown_ptr<T>&& get_row(uint64_t key)
-  {
-    return std::move(map[key]);
-  }
-
-  uint64_t insert_row(cown_ptr<T> r)
+  static constexpr uint64_t capacity()
   {
-    if (cnt < DB_SIZE)
-    {
-      map[cnt] = r;
-      return cnt++;
-    }
-    else
-    {
-      throw std::out_of_range("Index is full");
-    }
+    return DB_SIZE;
   }
 };
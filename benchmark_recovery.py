@@ -0,0 +1,81 @@
+#!/usr/bin/env python3
+import csv, os, subprocess, shutil
+from pathlib import Path
+import itertools
+
+# ─── CONFIG ────────────────────────────────────────────
+db_sizes              = [100_000, 1_000_000, 10_000_000]
+checkpoint_thresholds = [10000, 40000, 160000]
+crash_points          = ["checkpoint-rows", "fold-base", "fold-reclaim", "none"]
+num_txns              = 2_000_000
+workers               = 8
+
+repo_root   = Path(__file__).parent.resolve()
+app_dir     = repo_root / "app"
+build_dir   = app_dir   / "build" / "recovery"
+db_dir      = build_dir / "db"
+results_csv = build_dir / "recovery_results.csv"
+# ────────────────────────────────────────────────────────
+
+def run(cmd, cwd, env=None):
+    print(f"> {' '.join(cmd)}  (in {cwd})")
+    return subprocess.run(cmd, cwd=cwd, env=env, stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+
+def build():
+    build_dir.mkdir(parents=True, exist_ok=True)
+    run([
+        "cmake", str(app_dir),
+        "-GNinja",
+        "-DCMAKE_BUILD_TYPE=Release",
+    ], cwd=build_dir).check_returncode()
+    run(["ninja", "recovery_bench"], cwd=build_dir).check_returncode()
+
+def bench(mode, rows, thr, extra, crash=None):
+    env = dict(os.environ)
+    env.pop("DORADD_CRASH_POINT", None)
+    if crash:
+        env["DORADD_CRASH_POINT"] = crash
+    return run([
+        str(build_dir / "recovery_bench"), mode, str(db_dir),
+        "-r", str(rows), "-t", str(num_txns), "-w", str(workers),
+        "--txn-threshold", str(thr),
+    ] + extra, cwd=build_dir, env=env)
+
+def main():
+    build()
+
+    with open(results_csv, "w", newline="") as f:
+        out = csv.writer(f)
+        out.writerow(["rows", "threshold", "crash_point", "crashed", "recovered_rows",
+                      "resume_txn", "total_ms", "scan_ms", "decode_ms", "install_ms",
+                      "replay_ms", "verified"])
+
+        for rows, thr in itertools.product(db_sizes, checkpoint_thresholds):
+            # Reference: the same workload without a crash
+            digest = build_dir / f"digest_{rows}_{thr}.txt"
+            r = bench("run", rows, thr, ["-o", str(digest)])
+            r.check_returncode()
+
+            for crash in crash_points:
+                r = bench("run", rows, thr, [], crash=None if crash == "none" else crash)
+                crashed = r.returncode == -9
+                if r.returncode != 0 and not crashed:
+                    print(f"⚠️  run failed (exit {r.returncode})")
+                    continue
+
+                r = bench("recover", rows, thr, ["-c", str(digest)])
+                (build_dir / f"recover_{rows}_{thr}_{crash}.log").write_bytes(r.stdout)
+                result = [l for l in r.stdout.decode().splitlines() if l.startswith("RESULT,")]
+                if not result:
+                    print(f"⚠️  recovery failed (exit {r.returncode})")
+                    continue
+                fields = result[-1].split(",")[1:]
+                out.writerow([rows, thr, crash, crashed] + fields[2:])
+                f.flush()
+                print(f"→ rows={rows} thr={thr} crash={crash}: total {fields[4]} ms, verified={fields[-1]}")
+
+    shutil.rmtree(db_dir, ignore_errors=True)
+    print(f"✅ Results in {results_csv}")
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,48 @@
+#!/usr/bin/env python3
+"""Prints percentiles from the binary latency histograms written under
+LOG_LATENCY (results/<gen_type>-latency.hist, see latency_histogram.hpp)."""
+import struct
+import sys
+
+MAGIC = 0x4c415448
+
+def bucket_upper(b, sub_bits):
+    sub_buckets = 1 << sub_bits
+    if b < sub_buckets:
+        return b
+    shift = b // sub_buckets - 1
+    return ((b % sub_buckets + sub_buckets + 1) << shift) - 1
+
+def load(path):
+    with open(path, "rb") as f:
+        magic, sub_bits, nbuckets, nthreads = struct.unpack("<4I", f.read(16))
+        if magic != MAGIC:
+            sys.exit(f"{path}: not a latency histogram")
+        counts = [0] * nbuckets
+        max_ns = 0
+        for _ in range(nthreads):
+            row = struct.unpack(f"<{nbuckets + 1}Q", f.read(8 * (nbuckets + 1)))
+            max_ns = max(max_ns, row[0])
+            counts = [a + b for a, b in zip(counts, row[1:])]
+    return sub_bits, counts, max_ns, nthreads
+
+def percentile(counts, sub_bits, total, p):
+    rank, seen = int(p * total), 0
+    for b, c in enumerate(counts):
+        seen += c
+        if seen > rank:
+            return bucket_upper(b, sub_bits)
+    return 0
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit(f"Usage: {sys.argv[0]} <file.hist>")
+    sub_bits, counts, max_ns, nthreads = load(sys.argv[1])
+    total = sum(counts)
+    print(f"threads: {nthreads}  transactions: {total}")
+    for p in (0.5, 0.9, 0.99, 0.999, 0.9999):
+        print(f"p{p * 100:g}: {percentile(counts, sub_bits, total, p) / 1e3:.1f} us")
+    print(f"max: {max_ns / 1e3:.1f} us")
+
+if __name__ == "__main__":
+    main()
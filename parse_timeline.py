@@ -0,0 +1,51 @@
+#!/usr/bin/env python3
+"""Shows what each checkpoint phase costs in throughput and tail latency,
+from the event timeline written at the end of a run
+(results/<gen_type>-timeline.csv, see timeline.hpp)."""
+import csv
+import sys
+from collections import defaultdict
+
+PHASES = ["collect", "dispatch", "write", "commit", "flush", "done", "fold", "gc"]
+
+def overlaps(sample, phases):
+    return any(p[0] < sample["end"] and sample["start"] < p[1] for p in phases)
+
+def mean(xs):
+    return sum(xs) / len(xs) if xs else float("nan")
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit(f"Usage: {sys.argv[0]} <timeline.csv>")
+    phases = defaultdict(list)
+    samples = {"throughput": [], "latency": []}
+    with open(sys.argv[1]) as f:
+        for row in csv.DictReader(f):
+            ev = {"start": float(row["start_us"]), "end": float(row["end_us"]),
+                  "v": [int(row["v0"]), int(row["v1"]), int(row["v2"])]}
+            if row["kind"] in samples:
+                samples[row["kind"]].append(ev)
+            elif row["kind"] in PHASES:
+                phases[row["kind"]].append((ev["start"], ev["end"]))
+
+    any_phase = [p for k in PHASES for p in phases[k]]
+    quiet_tput = [s["v"][1] for s in samples["throughput"] if not overlaps(s, any_phase)]
+    quiet_p99 = [s["v"][1] for s in samples["latency"] if not overlaps(s, any_phase)]
+    print(f"outside checkpoints: exec {mean(quiet_tput):,.0f} tx/s, "
+          f"p99 {mean(quiet_p99) / 1e3:.1f} us ({len(quiet_tput)} samples)")
+
+    print(f"{'phase':<10} {'count':>6} {'mean ms':>9} {'exec tx/s':>14} {'vs quiet':>9} "
+          f"{'p99 us':>9} {'p999 us':>9}")
+    for k in PHASES:
+        if not phases[k]:
+            continue
+        durs = [(e - s) / 1e3 for s, e in phases[k]]
+        tput = [s["v"][1] for s in samples["throughput"] if overlaps(s, phases[k])]
+        lat = [s for s in samples["latency"] if overlaps(s, phases[k])]
+        rel = f"{100 * (mean(tput) / mean(quiet_tput) - 1):+8.1f}%" if tput and quiet_tput else ""
+        print(f"{k:<10} {len(durs):>6} {mean(durs):>9.2f} {mean(tput):>14,.0f} {rel:>9} "
+              f"{mean([s['v'][1] for s in lat]) / 1e3:>9.1f} "
+              f"{mean([s['v'][2] for s in lat]) / 1e3:>9.1f}")
+
+if __name__ == "__main__":
+    main()
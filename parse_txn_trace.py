@@ -0,0 +1,88 @@
+#!/usr/bin/env python3
+"""Breaks end-to-end latency down by pipeline stage from the sampled
+transaction trace written under TXN_TRACE (results/<gen_type>-txn.trace, see
+txn_trace.hpp)."""
+import struct
+import sys
+from collections import defaultdict
+
+MAGIC = 0x54585452
+EVENTS = ["arrival", "indexed", "prefetched", "spawned", "begin", "end"]
+# (name, from event, to event)
+SEGMENTS = [
+    ("admission", "arrival", "indexed"),
+    ("index->prefetch", "indexed", "prefetched"),
+    ("prefetch->spawn", "prefetched", "spawned"),
+    ("scheduling", "spawned", "begin"),
+    ("execution", "begin", "end"),
+]
+
+def load(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    magic, version, sample, _, ns_fp = struct.unpack_from("<4IQ", data, 0)
+    if magic != MAGIC or version != 1:
+        sys.exit(f"{path}: not a transaction trace")
+    nthreads, footer_magic = struct.unpack_from("<2I", data, len(data) - 8)
+    if footer_magic != MAGIC:
+        sys.exit(f"{path}: truncated trace (run did not stop cleanly)")
+    table = len(data) - 8 - 16 * nthreads
+    threads = {}
+    for i in range(nthreads):
+        tid, name = struct.unpack_from("<H14s", data, table + 16 * i)
+        threads[tid] = name.rstrip(b"\0").decode()
+    txns = defaultdict(dict)
+    for off in range(24, table, 16):
+        tsc, txn, tid, ev, _ = struct.unpack_from("<QIHBB", data, off)
+        txns[txn][EVENTS[ev]] = (tsc, tid)
+    return sample, ns_fp / 2**32, threads, txns
+
+def pct(sorted_vals, p):
+    return sorted_vals[min(len(sorted_vals) - 1, int(p * len(sorted_vals)))]
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit(f"Usage: {sys.argv[0]} <file.trace>")
+    sample, ns_per_cycle, threads, txns = load(sys.argv[1])
+    us = lambda cycles: cycles * ns_per_cycle / 1e3
+
+    segs = {name: [] for name, _, _ in SEGMENTS}
+    total = []
+    per_worker = defaultdict(lambda: [0, 0.0, 0.0])
+    complete = 0
+    for ev in txns.values():
+        for name, a, b in SEGMENTS:
+            if a in ev and b in ev:
+                segs[name].append(us(ev[b][0] - ev[a][0]))
+        if all(e in ev for e in EVENTS):
+            complete += 1
+            total.append(us(ev["end"][0] - ev["arrival"][0]))
+            w = per_worker[threads.get(ev["begin"][1], "?") + f"#{ev['begin'][1]}"]
+            w[0] += 1
+            w[1] += us(ev["begin"][0] - ev["spawned"][0])
+            w[2] += us(ev["end"][0] - ev["begin"][0])
+
+    print(f"sampled 1 in {sample}: {len(txns)} transactions, {complete} with all events")
+    total_mean = sum(total) / len(total) if total else 0
+    print(f"{'segment':<16} {'n':>8} {'mean':>10} {'p50':>10} {'p99':>10} {'p999':>10} {'share':>7}  (us)")
+    for name, vals in list(segs.items()) + [("end-to-end", total)]:
+        if not vals:
+            continue
+        vals.sort()
+        mean = sum(vals) / len(vals)
+        share = f"{100 * mean / total_mean:6.1f}%" if total_mean else ""
+        print(f"{name:<16} {len(vals):>8} {mean:>10.2f} {pct(vals, .5):>10.2f} "
+              f"{pct(vals, .99):>10.2f} {pct(vals, .999):>10.2f} {share:>7}")
+
+    if total_mean:
+        queueing = sum(sum(segs[n]) / len(segs[n]) for n, _, _ in SEGMENTS[:4] if segs[n])
+        print(f"\nqueueing/scheduling: {100 * queueing / total_mean:.1f}% of mean latency, "
+              f"execution: {100 * (total_mean - queueing) / total_mean:.1f}%")
+
+    if per_worker:
+        print(f"\n{'worker':<16} {'n':>8} {'sched':>10} {'exec':>10}  (mean us)")
+        for name, (n, sched, exe) in sorted(per_worker.items()):
+            print(f"{name:<16} {n:>8} {sched / n:>10.2f} {exe / n:>10.2f}")
+
+if __name__ == "__main__":
+    main()
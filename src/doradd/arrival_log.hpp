@@ -0,0 +1,84 @@
+#pragma once
+
+#include "tsc.hpp"
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+
+// Request arrival times for RPC_LATENCY.
+//
+// The RPC handler stamps request i into slot i % capacity with the time it
+// was scheduled to arrive; the spawner reads
+// the stamps back in the same order and hands them to the transactions.
+// Each slot holds the low 32 bits of (rdtsc - epoch) >> SHIFT, and the
+// reader rebuilds the full value from the previous arrival, which is exact
+// as long as consecutive arrivals are less than 2^32 units (~20 s) apart.
+// The ring therefore only needs to cover requests in flight, not the whole
+// run, and is mapped lazily instead of being zeroed up front.
+class ArrivalLog
+{
+public:
+  static constexpr uint32_t SHIFT = 4; // 16-cycle units, ~5 ns
+
+  // `capacity` must be a power of two
+  explicit ArrivalLog(size_t capacity) : mask(capacity - 1)
+  {
+    if (capacity == 0 || (capacity & mask) != 0)
+    {
+      fprintf(stderr, "ArrivalLog capacity must be a power of two\n");
+      exit(1);
+    }
+    size_t bytes = capacity * sizeof(uint32_t);
+    void* p = mmap(
+      nullptr,
+      bytes,
+      PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+      -1,
+      0);
+    if (p == MAP_FAILED)
+    {
+      perror("ArrivalLog mmap");
+      exit(1);
+    }
+    madvise(p, bytes, MADV_HUGEPAGE);
+    slots = static_cast<uint32_t*>(p);
+    epoch = rdtsc();
+  }
+
+  // Writer: stamps request `i` with arrival time `at` (a TSC value, no
+  // earlier than the epoch). Returns false if the slot still belongs to a
+  // request that has not been dispatched yet.
+  bool record(uint64_t i, uint64_t at)
+  {
+    if (i - dispatched.load(std::memory_order_relaxed) > mask)
+      return false;
+    slots[i & mask] = static_cast<uint32_t>((at - epoch) >> SHIFT);
+    return true;
+  }
+
+  // Reader: arrival TSC of request `i`. Requests must be read in order.
+  uint64_t arrival(uint64_t i)
+  {
+    uint32_t v = slots[i & mask];
+    last += static_cast<uint32_t>(v - static_cast<uint32_t>(last));
+    return epoch + (last << SHIFT);
+  }
+
+  // Reader: requests below `n` are dispatched and their slots can be reused
+  void release(uint64_t n)
+  {
+    dispatched.store(n, std::memory_order_relaxed);
+  }
+
+private:
+  uint32_t* slots;
+  uint64_t mask;
+  uint64_t epoch;
+  uint64_t last = 0;
+  alignas(64) std::atomic<uint64_t> dispatched{0};
+};
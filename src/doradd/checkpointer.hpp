@@ -1,6 +1,7 @@
 #pragma once
 
 #include <chrono>
+#include <concepts>
 #include <cstdint>
 #include <limits>
 #include <mutex>
@@ -14,10 +15,16 @@
 #include <optional>
 #include <filesystem>
 #include <fstream>
-#include <deque>
+#include <condition_variable>
+#include <string_view>
+#include <type_traits>
 #include "pin-thread.hpp"
-#include "checkpoint_stats.hpp"
+#include "timeline.hpp"
+#include "../storage/storage.hpp"
 #include "../storage/garbage_collector.hpp"
+#include "../storage/snapshot_manifest.hpp"
+#include "recovery.hpp"
+#include "crash_point.hpp"
 #ifndef CHECKPOINT_BATCH_SIZE
 #  error "You must define CHECKPOINT_BATCH_SIZE"
 #endif
@@ -89,25 +96,47 @@ template<typename StorageType, typename TxnType, typename RowType = TxnType>
 class Checkpointer {
 public:
   static constexpr int CHECKPOINT_MARKER = -1;
-  static constexpr size_t MAX_STORED_INTERVALS = 1000;  // Maximum number of intervals to store
+  static constexpr size_t MAX_STORED_INTERVALS = 1000;  // Intervals kept for get_interval_ms()
+  static constexpr size_t DEFAULT_MAX_INCREMENTALS = 8;  // Incrementals kept before folding into a new base
+  static constexpr size_t MERGE_WRITE_BATCH = 1024;      // Rows per storage batch when writing a base
+  static constexpr size_t DEFAULT_BULK_THRESHOLD = 1'000'000;  // Dirty rows above which SST ingestion is used
+  static constexpr size_t BULK_RANGE_ROWS = 1 << 16;           // Rows per SST file on the bulk path
 
   Checkpointer(const std::string& path = DefaultDBPath)
     : tx_count_threshold(DefaultThreshold), last_finish(clock::now()) {
     if (!storage.open(path)) throw std::runtime_error("Failed to open DB");
-    std::string meta_prefix = "_meta_bit";
-    bits.resize(10'000'000);
-    for (auto& kv : storage.scan_prefix(meta_prefix)) {
-      uint64_t k = std::stoull(kv.first.substr(0, kv.first.size() - meta_prefix.size()));
-      bits[k] = (kv.second.size()>0 && kv.second[0]=='1');
-    }
 
-    // Initialize garbage collector
-    gc = std::make_unique<GarbageCollector>(storage);
+    // Continue the snapshot chain of a previous run, if any
+    std::string manifest_str;
+    if (storage.get(snapshot_keys::MANIFEST_KEY, manifest_str) &&
+        !SnapshotManifest::parse(manifest_str, manifest)) {
+      throw std::runtime_error("Corrupted snapshot manifest: " + manifest_str);
+    }
+    current_snapshot.store(manifest.latest(), std::memory_order_relaxed);
+    std::string txns_str;
+    if (storage.get("total_txns", txns_str))
+      total_transactions.store(std::stoull(txns_str), std::memory_order_relaxed);
+
+    // Nothing is writing snapshots yet, so anything the manifest does not
+    // reference is left over from a crashed checkpoint or fold
+    uint64_t gc_start = timeline::now();
+    size_t orphans = gc.collect_orphans(manifest);
+    timeline::record(timeline::GC, 0, gc_start, orphans);
+
+    merger_thread = std::thread([this]() { merger_loop(); });
   }
 
   ~Checkpointer() {
-    std::lock_guard<std::mutex> lg(completion_mu);
-    if (completion_thread.joinable()) completion_thread.join();
+    {
+      std::lock_guard<std::mutex> lg(completion_mu);
+      if (completion_thread.joinable()) completion_thread.join();
+    }
+    {
+      std::lock_guard<std::mutex> lg(manifest_mu);
+      stop_merger = true;
+    }
+    merger_cv.notify_one();
+    if (merger_thread.joinable()) merger_thread.join();
   }
 
   void set_index(Index<RowType>* idx) { if (!index) index = idx; }
@@ -125,39 +154,71 @@ public:
 
   void schedule_checkpoint(rigtorp::SPSCQueue<int>* ring, std::vector<uint64_t>&& dirty_keys) {
     if (!checkpoint_in_flight.exchange(true, std::memory_order_acq_rel)) {
+      uint64_t start = timeline::now();
+      marker_tsc.store(start, std::memory_order_relaxed);
       ring->push(CHECKPOINT_MARKER);
       int prev = current_diff_idx.exchange(1 - current_diff_idx.load(std::memory_order_relaxed), std::memory_order_relaxed);
       diffs[prev].swap(dirty_keys);
-      tx_counts.push_back(tx_count_since_last_checkpoint.load(std::memory_order_relaxed));
+      timeline::record(timeline::CKPT_MARKER, current_snapshot.load(std::memory_order_relaxed) + 1, start,
+                       tx_count_since_last_checkpoint.load(std::memory_order_relaxed));
       tx_count_since_last_checkpoint.store(0, std::memory_order_relaxed);
       tx_during_last_checkpoint.store(0, std::memory_order_relaxed);
     }
   }
 
   void process_checkpoint_request(rigtorp::SPSCQueue<int>* ring) {
-       // 1) Wait for any previous checkpoint to finish
+    // 1) Wait for the previous checkpoint to commit, so snapshots reach
+    //    the manifest one at a time and in id order
     {
         std::lock_guard<std::mutex> lg(completion_mu);
         if (completion_thread.joinable())
             completion_thread.join();
     }
 
-    // 2) Pop the marker and clear the in‐flight flag
+    // 2) Pop the marker and clear the in‐flight flag. Every transaction
+    //    counted so far was spawned before the marker, so this is exactly
+    //    the set of transactions the snapshot reflects.
+    size_t snapshot_txns = total_transactions.load(std::memory_order_relaxed);
     ring->pop();
     checkpoint_in_flight.store(false, std::memory_order_relaxed);
 
     // 3) Grab the current dirty‐keys list and reset it
+    uint64_t collect_start = timeline::now();
     int idx = 1 - current_diff_idx.load(std::memory_order_relaxed);
     auto keys_ptr = std::make_shared<std::vector<uint64_t>>(std::move(diffs[idx]));
     diffs[idx].clear();
+    if (!retry_keys.empty()) {
+        // Rows of a checkpoint that failed to commit are written again here
+        keys_ptr->insert(keys_ptr->end(), retry_keys.begin(), retry_keys.end());
+        retry_keys.clear();
+        std::sort(keys_ptr->begin(), keys_ptr->end());
+        keys_ptr->erase(std::unique(keys_ptr->begin(), keys_ptr->end()), keys_ptr->end());
+    }
+
+    // Large checkpoints bypass the write path of the store: keys are sorted
+    // and cut into ranges of BULK_RANGE_ROWS rows, and each range goes to
+    // the store's SST writers as soon as its last batch is serialized, so
+    // files are built while other rows are still being collected.
+    auto bulk = begin_bulk(keys_ptr->size());
+    std::shared_ptr<std::vector<BulkRange>> ranges;
+    constexpr size_t range_rows = (BULK_RANGE_ROWS + BatchSize - 1) / BatchSize * BatchSize;
+    if (bulk) {
+        std::sort(keys_ptr->begin(), keys_ptr->end());
+        size_t n = keys_ptr->size();
+        ranges = std::make_shared<std::vector<BulkRange>>((n + range_rows - 1) / range_rows);
+        for (size_t r = 0; r < ranges->size(); ++r) {
+            size_t len = std::min(range_rows, n - r * range_rows);
+            (*ranges)[r].rows.resize(len);
+            // Batches never straddle ranges; a partial last batch runs row by row
+            (*ranges)[r].pending.store(len / BatchSize + len % BatchSize, std::memory_order_relaxed);
+        }
+    }
 
     // 4) Collect the corresponding cowns
     std::vector<cown_ptr<RowType>> cows;
     cows.reserve(keys_ptr->size());
-    for (uint64_t k : *keys_ptr) {
-        if (auto p = index->get_row_addr(k))
-            cows.push_back(*p);
-    }
+    for (uint64_t k : *keys_ptr)
+        cows.push_back(index->get_row(k));
 
     // 5) Calculate number of batches and create a latch
     size_t num_batches = cows.size() / BatchSize + cows.size() % BatchSize;
@@ -165,44 +226,99 @@ public:
 
     // 6) Allocate a new snapshot ID for this checkpoint
     uint64_t snap = current_snapshot.fetch_add(1, std::memory_order_relaxed) + 1;
+    timeline::record(timeline::CKPT_COLLECT, snap, collect_start, cows.size());
 
     // 7) Define the per‐batch write operation
-    auto op = [this, latch, keys_ptr, snap](const uint64_t* key_ptr, RowType** items, size_t cnt) {
+    auto op = [this, latch, keys_ptr, snap, bulk, ranges](const uint64_t* key_ptr, RowType** items, size_t cnt) {
+        if constexpr (HAS_BULK) {
+            if (bulk) {
+                size_t pos = key_ptr - keys_ptr->data();
+                BulkRange& range = (*ranges)[pos / range_rows];
+                size_t off = pos % range_rows;
+                for (size_t i = 0; i < cnt; ++i) {
+                    range.rows[off + i] = {
+                        snapshot_keys::row_key(snapshot_keys::INCREMENTAL, snap, key_ptr[i]),
+                        std::string(reinterpret_cast<const char*>(items[i]), sizeof(RowType))};
+                }
+                if (range.pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                    bulk->add_range(std::move(range.rows));
+                latch->count_down();
+                return;
+            }
+        }
         auto batch = storage.create_batch();
         for (size_t i = 0; i < cnt; ++i) {
             RowType& obj = *items[i];
             // serialize the row
             std::string data(reinterpret_cast<const char*>(&obj), sizeof(RowType));
-            // write under "<row_id>_v<version_id>"
-            std::string versioned_key = std::to_string(*key_ptr) + "_v" + std::to_string(snap);
-            storage.add_to_batch(batch, versioned_key, data);
+            // write under the incremental snapshot "i<snap>/<row_id>"
+            storage.add_to_batch(batch, snapshot_keys::row_key(snapshot_keys::INCREMENTAL, snap, key_ptr[i]), data);
         }
         storage.commit_batch(batch);
         latch->count_down();
     };
 
     // 8) Dispatch all the batches
+    uint64_t dispatch_start = timeline::now();
     for (size_t i = 0; i < cows.size(); i += BatchSize) {
         batch_helpers::process_n_cowns<BatchSize>(cows, *keys_ptr, i, op);
     }
+    uint64_t dispatch_end = timeline::now();
+    timeline::Timeline::instance().record(timeline::CKPT_DISPATCH, snap, dispatch_start, dispatch_end, num_batches);
+    uint64_t marker = marker_tsc.load(std::memory_order_relaxed);
+    size_t rows = cows.size();
 
-    // 9) Once every batch has finished, write the global snapshot pointer and total_txns
+    // 9) Once every batch has finished, append the snapshot to the manifest
+    //    and write the global snapshot pointer and total_txns with it
     {
         std::lock_guard<std::mutex> lg(completion_mu);
-        completion_thread = std::thread([this, snap, latch]() {
+        completion_thread = std::thread([this, snap, snapshot_txns, latch, bulk, keys_ptr, dispatch_end, marker, rows]() {
             latch->wait();
-            auto batch = storage.create_batch();
-            // bump the global snapshot in the DB
-            storage.add_to_batch(batch, GLOBAL_SNAPSHOT_KEY, std::to_string(snap));
-            // persist the total‐transactions counter as before
-            storage.add_to_batch(batch,
-                                 "total_txns",
-                                 std::to_string(total_transactions.load(std::memory_order_relaxed)));
-            storage.commit_batch(batch);
-            storage.flush();
+            if constexpr (HAS_BULK) {
+                if (bulk && !bulk->finish()) {
+                    fail_checkpoint(snap, std::move(*keys_ptr), "failed to ingest rows");
+                    return;
+                }
+            }
+            timeline::record(timeline::CKPT_WRITE, snap, dispatch_end, rows);
+            crash_point("checkpoint-rows");
+            bool fold = false;
+            {
+                std::lock_guard<std::mutex> mlg(manifest_mu);
+                uint64_t commit_start = timeline::now();
+                SnapshotManifest next = manifest;
+                next.incrementals.push_back(snap);
+                auto batch = storage.create_batch();
+                storage.add_to_batch(batch, snapshot_keys::MANIFEST_KEY, next.serialize());
+                // bump the global snapshot in the DB
+                storage.add_to_batch(batch, GLOBAL_SNAPSHOT_KEY, std::to_string(snap));
+                // persist how many transactions the snapshot covers, so
+                // recovery knows where to resume replaying the log
+                storage.add_to_batch(batch, "total_txns", std::to_string(snapshot_txns));
+                uint64_t flush_start = 0;
+                std::string rows_prefix = snapshot_keys::prefix(snapshot_keys::INCREMENTAL, snap);
+                // The rows went out in earlier batches: check that none of
+                // them was lost before the manifest points at them
+                bool ok = rows_durable(rows_prefix) && commit(batch);
+                if (ok) {
+                    flush_start = timeline::now();
+                    timeline::Timeline::instance().record(timeline::CKPT_COMMIT, snap, commit_start, flush_start);
+                    ok = flush_storage(rows_prefix);
+                }
+                if (!ok) {
+                    // The manifest on disk still ends at the previous snapshot;
+                    // the rows written for this one are orphans
+                    fail_checkpoint(snap, std::move(*keys_ptr), "failed to commit");
+                    return;
+                }
+                manifest = std::move(next);
+                timeline::record(timeline::CKPT_FLUSH, snap, flush_start);
+                fold = manifest.incrementals.size() > max_incrementals;
+            }
+            if (fold) merger_cv.notify_one();
+            record_interval(snap, marker, rows);
             std::cout << "Checkpoint " << snap << " completed\n";
         });
-        completion_thread.detach();
     }
 }
 
@@ -218,50 +334,38 @@ size_t try_recovery()
         std::cout << "No total_txns key found; starting from zero\n";
     }
 
-    // 2) Load the last fully‐committed snapshot ID
-    uint64_t valid_snap = 0;
-    std::string snap_str;
-    if (storage.get(GLOBAL_SNAPSHOT_KEY, snap_str)) {
-        valid_snap = std::stoull(snap_str);
+    // 2) Load the manifest of the last fully‐committed snapshot
+    SnapshotManifest m;
+    {
+        std::lock_guard<std::mutex> lg(manifest_mu);
+        m = manifest;
     }
-    std::cout << "Recovering using snapshot " << valid_snap << "\n";
-
-    // 3) Scan all "<row_id>_v<version_id>" entries and pick, for each row_id, the highest version_id ≤ valid_snap
+    std::cout << "Recovering using base " << m.base << " and "
+              << m.incrementals.size() << " incremental(s) up to snapshot "
+              << m.latest() << "\n";
+
+    // 3) Read the snapshots newest first, each one on recovery_threads
+    //    threads. Rows are rebuilt in their arena slots, so the index must
+    //    be attached to its arena; Recovery::recover_into() does the same
+    //    before the rest of the database is loaded.
     if (index) {
-        std::unordered_map<uint64_t, std::pair<uint64_t,std::string>> best;
-        for (auto& kv : storage.scan_prefix("")) {
-            const std::string& key = kv.first;
-            // skip our special keys
-            if (key == "total_txns" || key == GLOBAL_SNAPSHOT_KEY) continue;
-            auto pos = key.rfind("_v");
-            if (pos == std::string::npos) continue;
-
-            uint64_t row_id = std::stoull(key.substr(0, pos));
-            uint64_t version_id = std::stoull(key.substr(pos + 2));
-            if (version_id > valid_snap) continue;
-
-            auto it = best.find(row_id);
-            if (it == best.end() || it->second.first < version_id) {
-                best[row_id] = {version_id, kv.second};
-            }
-        }
-
-        // 4) Deserialize and reinsert into the in-memory index
-        uint64_t max_seen = 0;
-        for (auto& [id, entry] : best) {
-            const std::string& data = entry.second;
+        std::vector<std::atomic<uint64_t>> claimed((index->capacity() + 63) / 64);
+        std::atomic<size_t> installed{0};
+        uint64_t max_seen = recover_snapshots(storage, m, index->capacity(), recovery_threads, claimed,
+          [&](uint64_t id, std::string_view data) {
+            // 4) Deserialize and reinsert into the in-memory index
             if (data.size() < sizeof(RowType)) {
                 std::cerr << "Corrupted row data for id=" << id << "\n";
-                continue;
+                return false;
             }
             RowType obj;
             std::memcpy(&obj, data.data(), sizeof(RowType));
-            auto cp = make_cown<RowType>(std::move(obj));
-            *index->get_row_addr(id) = std::move(cp);
-            max_seen = std::max(max_seen, id + 1);
-        }
-        index->set_count(max_seen);
-        std::cout << "Rebuilt index; highest key = "
+            index->install(id, std::move(obj));
+            installed.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        });
+        std::cout << "Rebuilt index with " << installed.load() << " rows on "
+                  << recovery_threads << " thread(s); highest key = "
                   << (max_seen ? max_seen - 1 : 0) << "\n";
     }
 
@@ -281,13 +385,18 @@ size_t try_recovery()
   }
 
   double get_avg_tx_between_checkpoints() const {
-    return number_of_checkpoints_done
-      ? double(total_transactions.load(std::memory_order_relaxed)) / double(number_of_checkpoints_done)
-      : 0.0;
+    size_t done = get_total_checkpoints();
+    return done ? double(total_transactions.load(std::memory_order_relaxed)) / double(done) : 0.0;
   }
 
   size_t get_total_checkpoints() const {
-    return number_of_checkpoints_done;
+    return number_of_checkpoints_done.load(std::memory_order_acquire);
+  }
+
+  // Checkpoints whose rows or manifest did not reach storage; their rows
+  // are written again by the next checkpoint
+  size_t get_failed_checkpoints() const {
+    return failed_checkpoints.load(std::memory_order_relaxed);
   }
 
   size_t get_total_transactions() const {
@@ -299,63 +408,215 @@ size_t try_recovery()
       if (std::string(argv[i]) == "--txn-threshold" && i+1 < argc) {
         try { tx_count_threshold = std::stoul(argv[++i]); }
         catch (...) { fprintf(stderr, "Invalid threshold: %s\n", argv[i]); }
+      } else if (std::string(argv[i]) == "--bulk-threshold" && i+1 < argc) {
+        try { bulk_threshold = std::stoul(argv[++i]); }
+        catch (...) { fprintf(stderr, "Invalid bulk threshold: %s\n", argv[i]); }
+      } else if (std::string(argv[i]) == "--recovery-threads" && i+1 < argc) {
+        try { recovery_threads = std::max<size_t>(1, std::stoul(argv[++i])); }
+        catch (...) { fprintf(stderr, "Invalid recovery thread count: %s\n", argv[i]); }
+      } else if (std::string(argv[i]) == "--max-incrementals" && i+1 < argc) {
+        try { max_incrementals = std::max<size_t>(1, std::stoul(argv[++i])); }
+        catch (...) { fprintf(stderr, "Invalid incremental count: %s\n", argv[i]); }
       }
     }
   }
 
-  std::vector<double> get_all_intervals_ms() const {
-    std::lock_guard<std::mutex> lg(intervals_mutex);
-    std::vector<double> result;
-    result.reserve(intervals.size());
-    for (uint64_t ns : intervals) {
-      result.push_back(ns * 1e-6);  // Convert to milliseconds
+  double get_interval_ms(size_t idx) const {
+    return idx < MAX_STORED_INTERVALS ? interval_ns[idx].load(std::memory_order_relaxed) * 1e-6 : 0.0;
+  }
+
+private:
+  // Streams the rows of the base and every incremental of `m` to
+  // visit(row_id, data) in row order, keeping only the newest version of a
+  // row. Each snapshot is already sorted by row id, so this is a k-way merge
+  // over one cursor per snapshot.
+  template<typename Visitor>
+  void merge_snapshots(const SnapshotManifest& m, Visitor&& visit) {
+    // sources[0] is the oldest; later sources shadow earlier ones
+    std::vector<typename StorageType::Cursor> sources;
+    if (m.base) sources.push_back(storage.cursor(snapshot_keys::prefix(snapshot_keys::BASE, m.base)));
+    for (uint64_t snap : m.incrementals)
+      sources.push_back(storage.cursor(snapshot_keys::prefix(snapshot_keys::INCREMENTAL, snap)));
+
+    while (true) {
+      uint64_t next = std::numeric_limits<uint64_t>::max();
+      size_t newest = sources.size();
+      for (size_t s = 0; s < sources.size(); ++s) {
+        if (!sources[s].valid()) continue;
+        uint64_t id = snapshot_keys::row_id(sources[s].key());
+        if (id <= next) { next = id; newest = s; }
+      }
+      if (newest == sources.size()) break;
+      visit(next, sources[newest].value());
+      for (auto& src : sources)
+        if (src.valid() && snapshot_keys::row_id(src.key()) == next) src.next();
     }
-    return result;
   }
 
-  double get_interval_ms(size_t idx) const {
-    std::lock_guard<std::mutex> lg(intervals_mutex);
-    return intervals[idx] * 1e-6;
+  // Called by the completion thread of each checkpoint, one at a time
+  void record_interval(uint64_t snap, uint64_t marker, size_t rows) {
+    auto now = clock::now();
+    uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now - last_finish).count();
+    last_finish = now;
+    total_interval_ns.fetch_add(ns, std::memory_order_relaxed);
+    interval_count.fetch_add(1, std::memory_order_relaxed);
+    size_t done = number_of_checkpoints_done.load(std::memory_order_relaxed);
+    if (done < MAX_STORED_INTERVALS) interval_ns[done].store(ns, std::memory_order_relaxed);
+    number_of_checkpoints_done.store(done + 1, std::memory_order_release);
+    timeline::record(timeline::CKPT_DONE, snap, marker, rows, ns);
+  }
+
+  static constexpr bool HAS_BULK = requires(StorageType& s) { s.begin_bulk(); };
+
+  // Rows of one bulk range, filled by the batches that serialize them
+  struct BulkRange {
+    std::vector<std::pair<std::string, std::string>> rows;
+    std::atomic<size_t> pending{0};  // batches still to serialize
+  };
+
+  // Bulk load session for a checkpoint of `rows` dirty rows, or null
+  auto begin_bulk(size_t rows) {
+    if constexpr (HAS_BULK)
+      return rows >= bulk_threshold ? storage.begin_bulk() : decltype(storage.begin_bulk())();
+    else
+      return std::shared_ptr<void>();
+  }
+
+  // Called by the completion thread when snapshot `snap` could not be
+  // committed: reports it and hands its keys to the next checkpoint
+  void fail_checkpoint(uint64_t snap, std::vector<uint64_t>&& keys, const char* why) {
+    failed_checkpoints.fetch_add(1, std::memory_order_relaxed);
+    std::cerr << "Checkpoint " << snap << " " << why << "; its " << keys.size()
+              << " row(s) are retried by the next checkpoint\n";
+    retry_keys = std::move(keys);
   }
 
-  void print_intervals() const {
-    auto intervals_ms = get_all_intervals_ms();
-    printf("Checkpoint intervals (ms):\n");
-    for (size_t i = 0; i < intervals_ms.size(); ++i) {
-      printf("  %zu: %.3f\n", i, intervals_ms[i]);
+  // Stores whose commit_batch() and flush() return bool report writes that
+  // did not reach disk; the others log their errors and count as durable
+  template<typename Batch>
+  bool commit(Batch& batch) {
+    if constexpr (std::is_same_v<decltype(storage.commit_batch(batch)), bool>) {
+      return storage.commit_batch(batch);
+    } else {
+      storage.commit_batch(batch);
+      return true;
     }
   }
 
-  std::vector<size_t> get_all_tx_counts() const {
-    std::lock_guard<std::mutex> lg(intervals_mutex);
-    std::vector<size_t> result;
-    result.reserve(tx_counts.size());
-    for (size_t count : tx_counts) {
-      result.push_back(count);
+  // Stores that track lost rows per key prefix (SegmentStore) report only
+  // the ones under `prefix`, the rows of the committer that flushes, since
+  // another thread's flush may be the one that saw them fail
+  static constexpr bool HAS_PREFIX_FLUSH =
+    requires(StorageType& s, const std::string& p) { { s.flush(p) } -> std::same_as<bool>; };
+
+  bool flush_storage(const std::string& prefix) {
+    if constexpr (HAS_PREFIX_FLUSH) {
+      return storage.flush(prefix);
+    } else if constexpr (std::is_same_v<decltype(storage.flush()), bool>) {
+      return storage.flush();
+    } else {
+      storage.flush();
+      return true;
     }
-    return result;
   }
 
-  void print_tx_counts() const {
-    auto counts = get_all_tx_counts();
-    printf("Transactions between checkpoints:\n");
-    for (size_t i = 0; i < counts.size(); ++i) {
-      printf("  %zu: %zu\n", i, counts[i]);
+  // Whether every row under `prefix` written so far reached disk, checked
+  // before metadata that points at them is committed. Other stores report
+  // lost rows from their flush after the commit.
+  bool rows_durable(const std::string& prefix) {
+    if constexpr (HAS_PREFIX_FLUSH)
+      return storage.flush(prefix);
+    else
+      return true;
+  }
+
+  // Background merger: once the manifest holds more than max_incrementals
+  // snapshots, fold the base and all committed incrementals into a new base so
+  // that recovery reads a bounded number of snapshots.
+  void merger_loop() {
+    std::unique_lock<std::mutex> lk(manifest_mu);
+    while (true) {
+      merger_cv.wait(lk, [this]() {
+        return stop_merger ||
+               manifest.incrementals.size() > std::max(max_incrementals, retry_fold_above);
+      });
+      if (stop_merger) return;
+      SnapshotManifest folded = manifest;
+      lk.unlock();
+
+      uint64_t new_base = folded.incrementals.back();
+      auto start = clock::now();
+      uint64_t fold_start = timeline::now();
+      size_t rows = 0;
+      auto batch = storage.create_batch();
+      size_t in_batch = 0;
+      merge_snapshots(folded, [&](uint64_t id, std::string_view data) {
+        storage.add_to_batch(batch, snapshot_keys::row_key(snapshot_keys::BASE, new_base, id), std::string(data));
+        if (++in_batch == MERGE_WRITE_BATCH) {
+          storage.commit_batch(batch);
+          batch = storage.create_batch();
+          in_batch = 0;
+        }
+        ++rows;
+      });
+      if (in_batch) storage.commit_batch(batch);
+      std::string base_prefix = snapshot_keys::prefix(snapshot_keys::BASE, new_base);
+      bool ok = flush_storage(base_prefix);
+      crash_point("fold-base");
+
+      lk.lock();
+      // Incrementals committed while folding stay in the chain
+      SnapshotManifest next = manifest;
+      next.base = new_base;
+      next.incrementals.erase(
+        next.incrementals.begin(),
+        next.incrementals.begin() + folded.incrementals.size());
+      if (ok) {
+        auto mbatch = storage.create_batch();
+        storage.add_to_batch(mbatch, snapshot_keys::MANIFEST_KEY, next.serialize());
+        ok = commit(mbatch) && flush_storage(base_prefix);
+      }
+      if (!ok) {
+        // Keep the old chain and retry once another checkpoint has committed;
+        // the partial base is an orphan
+        std::cerr << "Fold into base " << new_base << " failed\n";
+        retry_fold_above = manifest.incrementals.size();
+        continue;
+      }
+      manifest = std::move(next);
+      retry_fold_above = 0;
+      timeline::record(timeline::FOLD, new_base, fold_start, rows);
+      lk.unlock();
+
+      // The folded snapshots are no longer reachable from the manifest, so
+      // they are reclaimed without holding up checkpoint commits
+      uint64_t gc_start = timeline::now();
+      if (folded.base) gc.reclaim(snapshot_keys::BASE, {folded.base});
+      crash_point("fold-reclaim");
+      gc.reclaim(snapshot_keys::INCREMENTAL, folded.incrementals);
+      timeline::record(timeline::GC, new_base, gc_start, folded.incrementals.size() + (folded.base ? 1 : 0));
+
+      auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+      std::cout << "Folded " << folded.incrementals.size() << " incremental(s) into base "
+                << new_base << " (" << rows << " rows, " << ms << " ms)\n";
+      lk.lock();
     }
   }
 
-private:
   StorageType storage;
   Index<RowType>* index = nullptr;
   std::atomic<bool> checkpoint_in_flight{false};
   std::atomic<int> current_diff_idx{0};
   std::array<std::vector<uint64_t>, 2> diffs;
   std::thread completion_thread;
+  std::vector<uint64_t> retry_keys;  // written by a failed completion thread, read after joining it
+  std::atomic<size_t> failed_checkpoints{0};
   std::mutex completion_mu;
   std::mutex write_mu;
-  mutable std::mutex intervals_mutex;
-  std::vector<bool> bits;
   size_t tx_count_threshold;
+  size_t max_incrementals{DEFAULT_MAX_INCREMENTALS};
+  size_t bulk_threshold{DEFAULT_BULK_THRESHOLD};
+  size_t recovery_threads{std::max(1u, std::thread::hardware_concurrency())};
   std::atomic<size_t> tx_count_since_last_checkpoint{0};
   std::atomic<size_t> total_transactions{0};
   std::atomic<size_t> tx_during_last_checkpoint{0};
@@ -363,12 +624,18 @@ private:
   std::atomic<uint64_t> total_interval_ns{0};
   std::atomic<size_t> interval_count{0};
   clock::time_point last_finish;
-  int number_of_checkpoints_done{0};
-  std::deque<uint64_t> intervals;  // Store individual intervals in nanoseconds
-  std::deque<size_t> tx_counts;    // Store transaction counts between checkpoints  
+  std::atomic<size_t> number_of_checkpoints_done{0};
+  std::array<std::atomic<uint64_t>, MAX_STORED_INTERVALS> interval_ns{};  // Time between checkpoint completions
+  std::atomic<uint64_t> marker_tsc{0};  // When the in-flight checkpoint's marker was scheduled
   std::atomic<uint64_t> current_snapshot{0}; // Store the current snapshot ID
   static constexpr const char* GLOBAL_SNAPSHOT_KEY = "global_snapshot";
-  std::unique_ptr<GarbageCollector> gc;
+  SnapshotManifest manifest;       // Base plus incrementals, guarded by manifest_mu
+  std::mutex manifest_mu;
+  std::condition_variable merger_cv;
+  bool stop_merger{false};
+  size_t retry_fold_above{0};      // incrementals a failed fold waits to exceed
+  std::thread merger_thread;
+  GarbageCollector<StorageType> gc{storage};
 };
 
 
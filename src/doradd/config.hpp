@@ -9,6 +9,12 @@ static constexpr size_t BATCH_PREFETCHER = 8;
 static constexpr size_t BATCH_SPAWNER = 8;
 static constexpr size_t MAX_BATCH = 4;
 static constexpr uint64_t RPC_LOG_SIZE = 1000'000'000;
+// Arrival stamps kept for requests not yet dispatched (power of two)
+static constexpr uint64_t RPC_INFLIGHT_LOG_SIZE = 1ull << 24;
+// Arrival schedule: generator threads, requests per block, blocks buffered
+static constexpr size_t RPC_GEN_THREADS = 2;
+static constexpr size_t RPC_GEN_BLOCK = 4096;
+static constexpr size_t RPC_GEN_BLOCKS = 64;
 static constexpr uint64_t TX_COUNTER_LOG_SIZE = 400'000;
 static constexpr uint64_t ANNOUNCE_THROUGHPUT_BATCH_SIZE = 1000'000'000;
 static constexpr size_t CHANNEL_SIZE = 2;
@@ -1,78 +1,75 @@
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <filesystem>
 
-// Include the same storage type that your Checkpointer uses
-// You may need to adjust this based on your actual implementation
-#include "storage.hpp"  // Adjust this to your actual storage header
+#include "../storage/storage.hpp"
+#include "../storage/snapshot_manifest.hpp"
 
+// Prints the checkpoint metadata and every snapshot stored in a checkpoint
+// database. With --rows, also lists the row ids (and value sizes) of each
+// snapshot.
 int main(int argc, char** argv) {
-    if (argc != 2) {
-        std::cerr << "Usage: " << argv[0] << " <db_path>\n";
+    if (argc < 2 || argc > 3 || (argc == 3 && std::string(argv[2]) != "--rows")) {
+        std::cerr << "Usage: " << argv[0] << " <db_path> [--rows]\n";
         return 1;
     }
 
     std::string db_path = argv[1];
-    
+    bool print_rows = argc == 3;
+
     if (!std::filesystem::exists(db_path)) {
         std::cerr << "Database file not found: " << db_path << "\n";
         return 1;
     }
-    
+
     std::cout << "Opening database at: " << db_path << "\n";
-    
-    // Assuming StorageType is the same as used in your checkpointer
-    // Replace this with your actual storage type if different
-    StorageType storage;
-    
-    bool success = storage.open(db_path);
-    if (!success) {
+
+    CheckpointStore storage;
+    if (!storage.open(db_path)) {
         std::cerr << "Failed to open database.\n";
         return 1;
     }
-    
-    std::cout << "Successfully opened database.\n\n";
-    std::cout << "Database contents:\n";
-    std::cout << "=================\n";
 
-    // If your storage has a keys() or scan() method, use that
-    // Otherwise, this is an example implementation that might need adjustment
-    auto keys = storage.get_all_keys();
-    
-    if (keys.empty()) {
-        std::cout << "Database is empty.\n";
-        return 0;
+    std::string value;
+    SnapshotManifest manifest;
+    if (!storage.get(snapshot_keys::MANIFEST_KEY, value)) {
+        std::cout << "No manifest; no checkpoint was committed.\n";
+    } else if (!SnapshotManifest::parse(value, manifest)) {
+        std::cout << "Corrupted manifest: " << value << "\n";
+    } else {
+        std::cout << "Manifest: " << value << "\n";
     }
-    
-    size_t count = 0;
-    for (const auto& key : keys) {
-        std::string value;
-        if (storage.get(key, value)) {
-            std::cout << "Key: " << key << "\n";
-            
-            // For versioned keys (_v0, _v1), extract the original key
-            size_t pos = key.find("_v");
-            if (pos != std::string::npos) {
-                std::string original_key = key.substr(0, pos);
-                std::string version = key.substr(pos + 2);
-                std::cout << "  Original key: " << original_key << ", Version: " << version << "\n";
-            }
-            
-            std::cout << "  Value size: " << value.size() << " bytes\n";
-            // Print a preview of the value if it's not too large
-            if (value.size() <= 100) {
-                std::cout << "  Value (hex): ";
-                for (unsigned char c : value) {
-                    printf("%02x ", static_cast<unsigned int>(c));
-                }
-                std::cout << "\n";
-            }
-            std::cout << "---\n";
-            count++;
-        }
+    for (const char* key : {"global_snapshot", "total_txns"}) {
+        if (storage.get(key, value)) std::cout << key << ": " << value << "\n";
     }
-    
-    std::cout << "\nTotal records: " << count << "\n";
+
+    std::cout << "\nSnapshots:\n";
+    std::cout << "==========\n";
+    size_t total = 0;
+    for (const std::string& group : storage.list_groups()) {
+        size_t rows = 0, bytes = 0;
+        storage.for_each_prefix(group + "/", [&](std::string_view key, std::string_view v) {
+            if (print_rows)
+                std::cout << "  row " << snapshot_keys::row_id(key) << ": " << v.size() << " bytes\n";
+            ++rows;
+            bytes += v.size();
+        });
+
+        char kind = group.empty() ? '?' : group[0];
+        uint64_t snap = group.size() > 1 ? std::strtoull(group.c_str() + 1, nullptr, 16) : 0;
+        bool live = (kind == snapshot_keys::BASE && snap == manifest.base) ||
+                    (kind == snapshot_keys::INCREMENTAL &&
+                     std::find(manifest.incrementals.begin(), manifest.incrementals.end(), snap) !=
+                       manifest.incrementals.end());
+        std::cout << (kind == snapshot_keys::BASE ? "base " : "incr ") << snap << ": "
+                  << rows << " rows, " << bytes << " bytes" << (live ? "" : " (unreferenced)") << "\n";
+        total += rows;
+    }
+
+    std::cout << "\nTotal records: " << total << "\n";
     return 0;
-} 
\ No newline at end of file
+}
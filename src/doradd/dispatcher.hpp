@@ -5,10 +5,16 @@
 #include "warmup.hpp"
 #include "SPSCQueue.h"
 #include "checkpointer.hpp"
-#include "../storage/rocksdb.hpp"
+#include "stage_telemetry.hpp"
+#include "perf_counters.hpp"
+#include "arrival_log.hpp"
+#include "txn_trace.hpp"
+#include "worker_counters.hpp"
+#include "../storage/storage.hpp"
 
 #include <cassert>
 #include <fcntl.h>
+#include <filesystem>
 #include <mutex>
 #include <numeric>
 #include <stdio.h>
@@ -34,9 +40,6 @@ private:
   char* prepare_parse_read_head;
   char* prepare_proc_read_head;
 
-  std::unordered_map<std::thread::id, uint64_t*>* counter_map;
-  std::mutex* counter_map_mutex;
-  // std::vector<uint64_t*> counter_vec;
 
   uint64_t tx_count;
   uint64_t tx_spawn_sum;
@@ -45,35 +48,31 @@ private:
 
   std::atomic<uint64_t>* recvd_req_cnt;
   uint64_t handled_req_cnt = 0;
+  uint64_t txn_seq = 0;
 
   ts_type last_print;
 
 #ifdef RPC_LATENCY
-  uint64_t init_time_log_arr;
+  ArrivalLog* arrivals;
   int txn_log_id = 0;
-  ts_type init_time;
 #endif
 
 public:
   FileDispatcher(
     void* mmap_ret,
     uint8_t worker_cnt_,
-    std::unordered_map<std::thread::id, uint64_t*>* counter_map_,
-    std::mutex* counter_map_mutex_,
     std::atomic<uint64_t>* recvd_req_cnt_
 #ifdef RPC_LATENCY
     ,
-    uint64_t init_time_log_arr_
+    ArrivalLog* arrivals_
 #endif
     )
   : read_top(reinterpret_cast<char*>(mmap_ret)),
     worker_cnt(worker_cnt_),
-    counter_map(counter_map_),
-    counter_map_mutex(counter_map_mutex_),
     recvd_req_cnt(recvd_req_cnt_)
 #ifdef RPC_LATENCY
     ,
-    init_time_log_arr(init_time_log_arr_)
+    arrivals(arrivals_)
 #endif
   {
     rnd = 1;
@@ -90,25 +89,17 @@ public:
     last_tx_exec_sum = 0;
     counter_registered = false;
     last_print = std::chrono::system_clock::now();
-    ;
-#ifdef RPC_LATENCY
-    init_time = last_print;
-#endif
   }
 
   void track_worker_counter()
   {
-    if (counter_map->size() == worker_cnt)
+    if (WorkerCounters::instance().all_registered())
       counter_registered = true;
   }
 
   uint64_t calc_tx_exec_sum()
   {
-    uint64_t sum = 0;
-    for (const auto& counter_pair : *counter_map)
-      sum += *(counter_pair.second);
-
-    return sum;
+    return WorkerCounters::instance().executed();
   }
 
   size_t check_avail_cnts()
@@ -137,9 +128,7 @@ public:
 #ifdef RPC_LATENCY
   int dispatch_one()
   {
-    init_time = *reinterpret_cast<ts_type*>(
-      init_time_log_arr + (uint64_t)sizeof(ts_type) * txn_log_id);
-
+    uint64_t init_time = arrivals->arrival(txn_log_id);
     txn_log_id++;
     return T::parse_and_process(read_head, init_time);
   }
@@ -181,6 +170,7 @@ public:
     // dispatch
     for (j = 0; j < look_ahead; j++)
     {
+      txn_trace::spawn(txn_seq++);
       dispatch_ret = dispatch_one();
       read_head += dispatch_ret;
       ret += dispatch_ret;
@@ -189,6 +179,9 @@ public:
     }
 
     handled_req_cnt += look_ahead;
+#ifdef RPC_LATENCY
+    arrivals->release(txn_log_id);
+#endif
 
     return ret;
   }
@@ -259,19 +252,20 @@ struct Indexer
   char* read_top;
   std::atomic<uint64_t>* recvd_req_cnt;
   uint64_t handled_req_cnt;
-  Checkpointer<RocksDBStore, T, typename T::RowType>* checkpointer;
+  Checkpointer<CheckpointStore, T, typename T::RowType>* checkpointer;
 
   std::vector<bool> seen_keys;
   std::vector<uint64_t> dirty_keys;
 
   // inter-thread comm w/ the prefetcher
   rigtorp::SPSCQueue<int>* ring;
+  StageTelemetry stage_stats{"indexer"};
 
   Indexer(
     void* mmap_ret,
     rigtorp::SPSCQueue<int>* ring_,
     std::atomic<uint64_t>* req_cnt_,
-    Checkpointer<RocksDBStore, T, typename T::RowType>* checkpointer_
+    Checkpointer<CheckpointStore, T, typename T::RowType>* checkpointer_
     )
   : read_top(reinterpret_cast<char*>(mmap_ret)),
     ring(ring_),
@@ -315,14 +309,17 @@ struct Indexer
     char* read_head = read_top;
     int i, ret = 0;
     int batch; // = MAX_BATCH;
+    uint64_t txn_seq = 0;
 
 
     while (1)
     {
       if (checkpointer->should_checkpoint()) {
+        stage_stats.account(telemetry::BUSY);
         checkpointer->schedule_checkpoint(ring, std::move(dirty_keys));
         seen_keys.assign(seen_keys.size(), false);
         dirty_keys.clear();
+        stage_stats.account(telemetry::CHECKPOINT);
         continue;
       }
 
@@ -332,11 +329,14 @@ struct Indexer
         read_idx = 0;
       }
 
+      stage_stats.account(telemetry::BUSY);
       batch = check_avail_cnts();
+      stage_stats.account(telemetry::EMPTY_SPIN);
 
       for (i = 0; i < batch; i++)
       {
         ret = T::prepare_cowns(read_head);
+        txn_trace::point(txn_trace::INDEXED, txn_seq++, "indexer");
         auto txn = reinterpret_cast<T::Marshalled*>(read_head);
         auto indices_size = txn->indices_size;
         for (size_t i = 0; i < indices_size; i++) {
@@ -352,7 +352,10 @@ struct Indexer
         read_idx++;
       }
 
+      stage_stats.account(telemetry::BUSY);
       ring->push(batch);
+      stage_stats.account(telemetry::FULL_SPIN);
+      stage_stats.batch(batch, ring->size());
     }
   }
 };
@@ -363,6 +366,7 @@ struct Prefetcher
   char* read_top;
   uint32_t read_count;
   rigtorp::SPSCQueue<int>* ring;
+  StageTelemetry stage_stats{"prefetcher"};
 
 #if defined(INDEXER)
   rigtorp::SPSCQueue<int>* ring_indexer;
@@ -392,6 +396,7 @@ struct Prefetcher
     char* read_head = read_top;
     char* prepare_read_head = read_top;
     int batch_sz;
+    uint64_t txn_seq = 0;
 
     while (1)
     {
@@ -404,12 +409,16 @@ struct Prefetcher
 
 #ifdef INDEXER
       if (!ring_indexer->front())
+      {
+        stage_stats.account(telemetry::EMPTY_SPIN);
         continue;
+      }
 #endif
       int tag = *ring_indexer->front();
-      if (tag == Checkpointer<RocksDBStore, T>::CHECKPOINT_MARKER) {
+      if (tag == Checkpointer<CheckpointStore, T>::CHECKPOINT_MARKER) {
         ring_indexer->pop();
         ring->push(tag);
+        stage_stats.account(telemetry::CHECKPOINT);
         continue;
       }
       batch_sz = tag;
@@ -429,16 +438,20 @@ struct Prefetcher
 #else
         ret = T::prepare_process(read_head, RW, LLC_LOCALITY);
 #endif
+        txn_trace::point(txn_trace::PREFETCHED, txn_seq++, "prefetcher");
         read_head += ret;
         idx++;
       }
 
+      stage_stats.account(telemetry::BUSY);
 #ifdef INDEXER
       ring->push(batch_sz);
       ring_indexer->pop();
 #else
       ring->push(ret);
 #endif
+      stage_stats.account(telemetry::FULL_SPIN);
+      stage_stats.batch(batch_sz, ring->size());
     }
   }
 };
@@ -454,46 +467,43 @@ struct Spawner
   char* read_head;
   char* prepare_read_head;
   rigtorp::SPSCQueue<int>* ring;
-  std::unordered_map<std::thread::id, uint64_t*>* counter_map;
-  std::mutex* counter_map_mutex;
-  std::vector<uint64_t*> counter_vec; // FIXME
-  Checkpointer<RocksDBStore, T, typename T::RowType>* checkpointer;
+  Checkpointer<CheckpointStore, T, typename T::RowType>* checkpointer;
 
   uint64_t tx_exec_sum;
   uint64_t last_tx_exec_sum;
   uint64_t tx_spawn_sum;
+  FILE* res_throughput_fd; // results/spawn.txt, opened once
 
 #ifdef RPC_LATENCY
   uint64_t txn_log_id = 0;
-  uint64_t init_time_log_arr;
+  ArrivalLog* arrivals;
   FILE* res_log_fd;
-  ts_type init_time;
 #endif
 
   ts_type last_print;
+  StageTelemetry stage_stats{"spawner"};
+#ifdef PERF_COUNTERS
+  bool perf_started = false;
+#endif
 
   Spawner(
     void* mmap_ret,
     uint8_t worker_cnt_,
-    std::unordered_map<std::thread::id, uint64_t*>* counter_map_,
-    std::mutex* counter_map_mutex_,
     rigtorp::SPSCQueue<int>* ring_,
-    Checkpointer<RocksDBStore, T, typename T::RowType>* checkpointer_
+    Checkpointer<CheckpointStore, T, typename T::RowType>* checkpointer_
 #ifdef RPC_LATENCY
     ,
-    uint64_t init_time_log_arr_,
+    ArrivalLog* arrivals_,
     FILE* res_log_fd_
 #endif
     )
   : read_top(reinterpret_cast<char*>(mmap_ret)),
     worker_cnt(worker_cnt_),
-    counter_map(counter_map_),
-    counter_map_mutex(counter_map_mutex_),
     ring(ring_),
     checkpointer(checkpointer_)
 #ifdef RPC_LATENCY
     ,
-    init_time_log_arr(init_time_log_arr_),
+    arrivals(arrivals_),
     res_log_fd(res_log_fd_)
 #endif
   {
@@ -503,29 +513,25 @@ struct Spawner
     prepare_read_head = read_top;
     last_tx_exec_sum = 0;
     tx_spawn_sum = 0;
+    std::filesystem::create_directories("results");
+    res_throughput_fd = fopen("results/spawn.txt", "a");
   }
 
   void track_worker_counter()
   {
-    if (counter_map->size() == worker_cnt)
+    if (WorkerCounters::instance().all_registered())
       counter_registered = true;
   }
 
   uint64_t calc_tx_exec_sum()
   {
-    uint64_t sum = 0;
-    for (const auto& counter_pair : *counter_map)
-      sum += *(counter_pair.second);
-
-    return sum;
+    return WorkerCounters::instance().executed();
   }
 
 #ifdef RPC_LATENCY
   int dispatch_one()
   {
-    init_time = *reinterpret_cast<ts_type*>(
-      init_time_log_arr + (uint64_t)sizeof(ts_type) * txn_log_id);
-
+    uint64_t init_time = arrivals->arrival(txn_log_id);
     txn_log_id++;
     return T::parse_and_process(read_head, init_time);
   }
@@ -543,6 +549,7 @@ struct Spawner
     uint64_t tx_count = 0;
     size_t i;
     size_t batch_sz;
+    uint64_t txn_seq = 0;
     rnd = 1;
 
     // warm-up
@@ -560,11 +567,14 @@ struct Spawner
 #endif
 
       if (!ring->front()) {
+        stage_stats.account(telemetry::EMPTY_SPIN);
         continue;
       }
 
-      if (*ring->front() == Checkpointer<RocksDBStore, T>::CHECKPOINT_MARKER) {
+      if (*ring->front() == Checkpointer<CheckpointStore, T>::CHECKPOINT_MARKER) {
+        stage_stats.account(telemetry::BUSY);
         checkpointer->process_checkpoint_request(ring);
+        stage_stats.account(telemetry::CHECKPOINT);
         continue;
       }
 
@@ -573,6 +583,15 @@ struct Spawner
       if (!counter_registered)
         track_worker_counter();
 
+#ifdef PERF_COUNTERS
+      // Count from the first transaction on, so warm-up is excluded
+      if (!perf_started)
+      {
+        perf::Registry::instance().start();
+        perf_started = true;
+      }
+#endif
+
       if (idx > (read_count - MAX_BATCH))
       {
         read_head = read_top;
@@ -592,6 +611,7 @@ struct Spawner
 
       for (i = 0; i < batch_sz; i++)
       {
+        txn_trace::spawn(txn_seq++);
         ret = dispatch_one();
         read_head += ret;
         idx++;
@@ -599,8 +619,13 @@ struct Spawner
         tx_spawn_sum++;
       }
       checkpointer->increment_tx_count(batch_sz);
+#ifdef RPC_LATENCY
+      arrivals->release(txn_log_id);
+#endif
 
       ring->pop();
+      stage_stats.account(telemetry::BUSY);
+      stage_stats.batch(batch_sz, ring->size());
       // announce throughput
       if (tx_count >= ANNOUNCE_THROUGHPUT_BATCH_SIZE)
       {
@@ -609,25 +634,26 @@ struct Spawner
         auto dur_cnt = duration.count();
         if (counter_registered)
           tx_exec_sum = calc_tx_exec_sum();
-        FILE* res_throughput_fd = fopen("results/spawn.txt", "a");
         printf("spawn - %lf tx/s\n", tx_count / dur_cnt);
         printf(
           "exec  - %lf tx/s\n", (tx_exec_sum - last_tx_exec_sum) / dur_cnt);
         printf("dur in seconds: %lf\n", dur_cnt);
-        fprintf(res_throughput_fd, "spawn - %lf tx/s\n", tx_count / dur_cnt);
-        fprintf(res_throughput_fd, 
-          "exec  - %lf tx/s\n", (tx_exec_sum - last_tx_exec_sum) / dur_cnt);
-        fprintf(res_throughput_fd, "Number of checkpoints: %lu\n", checkpointer->get_total_checkpoints());
-        for (size_t i = 0; i < checkpointer->get_total_checkpoints(); i++) {
-          fprintf(res_throughput_fd, "Checkpoint %lu: %lf\n", i, checkpointer->get_interval_ms(i));
+#ifdef PERF_COUNTERS
+        perf::Registry::instance().report(
+          tx_count, counter_registered ? tx_exec_sum - last_tx_exec_sum : 0);
+#endif
+        if (res_throughput_fd)
+        {
+          fprintf(res_throughput_fd, "spawn - %lf tx/s\n", tx_count / dur_cnt);
+          fprintf(res_throughput_fd,
+            "exec  - %lf tx/s\n", (tx_exec_sum - last_tx_exec_sum) / dur_cnt);
+          size_t checkpoints = checkpointer->get_total_checkpoints();
+          fprintf(res_throughput_fd, "Number of checkpoints: %lu\n", checkpoints);
+          for (size_t i = 0; i < std::min(checkpoints, checkpointer->MAX_STORED_INTERVALS); i++)
+            fprintf(res_throughput_fd, "Checkpoint %lu: %lf\n", i, checkpointer->get_interval_ms(i));
+          fflush(res_throughput_fd);
         }
-        fflush(res_throughput_fd);
-        fclose(res_throughput_fd);
-        
-        // Print checkpoint intervals and transaction counts
-        checkpointer->print_intervals();
-        checkpointer->print_tx_counts();
-        
+
 #ifdef RPC_LATENCY
         // fprintf(res_log_fd, "%lf\n", tx_count / dur_cnt);
 #endif
@@ -1,17 +1,24 @@
-// Source:
-// https://mazzo.li/posts/check-huge-page.html
+#pragma once
 
+#include "pin-thread.hpp"
+
+#include <algorithm>
+#include <chrono>
 #include <errno.h>
 #include <fcntl.h>
-#include <linux/kernel-page-flags.h>
+#include <linux/mman.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <string>
 #include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/vfs.h>
+#include <thread>
 #include <unistd.h>
+#include <vector>
 
 #define localFail(...) \
   do \
@@ -24,124 +31,270 @@
 #define PAGE_SIZE (1 << 12)
 // huge page, 2MiB
 #define HPAGE_SIZE (1 << 21)
+// gigantic page, 1GiB
+#define GPAGE_SIZE (1ul << 30)
 
-// See <https://www.kernel.org/doc/Documentation/vm/pagemap.txt> for
-// format which these bitmasks refer to
-#define PAGEMAP_PRESENT(ent) (((ent) & (1ull << 63)) != 0)
-#define PAGEMAP_PFN(ent) ((ent) & ((1ull << 55) - 1))
-
-// Checks if the page pointed at by `ptr` is huge. Assumes that `ptr` has
-// already been allocated.
-static void check_huge_page(void* ptr)
+// Huge-page backed arenas.
+//
+//   --hugepages thp|2m|1g|<hugetlbfs mount>
+//
+// thp (the default) maps anonymous memory and asks for transparent huge
+// pages; 2m and 1g map explicitly reserved pages with MAP_HUGETLB, and a
+// directory maps an unlinked file on that hugetlbfs mount. If the requested
+// pages are not available the arena falls back to the next smaller source
+// down to THP. Arenas are pre-faulted by one thread per CPU, and huge-page
+// coverage is checked once from /proc/self/smaps instead of per page.
+namespace hpage
 {
-  int pagemap_fd = open("/proc/self/pagemap", O_RDONLY);
-  if (pagemap_fd < 0)
+  enum class Source
   {
-    localFail("could not open /proc/self/pagemap: %s", strerror(errno));
-  }
-  int kpageflags_fd = open("/proc/kpageflags", O_RDONLY);
-  if (kpageflags_fd < 0)
+    THP,
+    HUGETLB_2M,
+    HUGETLB_1G,
+    HUGETLBFS
+  };
+
+  struct Config
   {
-    localFail("could not open /proc/kpageflags: %s", strerror(errno));
-  }
+    Source source = Source::THP;
+    std::string dir;
+
+    static Config& instance()
+    {
+      static Config c;
+      return c;
+    }
+
+    void parse_args(int argc, char** argv)
+    {
+      for (int i = 1; i + 1 < argc; i++)
+      {
+        if (strcmp(argv[i], "--hugepages") != 0)
+          continue;
+        const char* v = argv[++i];
+        if (strcmp(v, "thp") == 0)
+          source = Source::THP;
+        else if (strcmp(v, "2m") == 0)
+          source = Source::HUGETLB_2M;
+        else if (strcmp(v, "1g") == 0)
+          source = Source::HUGETLB_1G;
+        else
+        {
+          source = Source::HUGETLBFS;
+          dir = v;
+        }
+      }
+    }
+  };
 
-  // each entry is 8 bytes long
-  uint64_t ent;
-  if (
-    pread(pagemap_fd, &ent, sizeof(ent), ((uintptr_t)ptr) / PAGE_SIZE * 8) !=
-    sizeof(ent))
+  struct Mapping
   {
-    localFail("could not read from pagemap\n");
-  }
+    char* addr;
+    size_t len;
+    size_t page; // page size backing the mapping, PAGE_SIZE for THP
+  };
 
-  if (!PAGEMAP_PRESENT(ent))
+  inline size_t round_up(size_t sz, size_t page)
   {
-    localFail("page not present in /proc/self/pagemap, did you allocate it?\n");
+    return (sz + page - 1) / page * page;
   }
-  if (!PAGEMAP_PFN(ent))
+
+  inline Mapping map_thp(size_t sz)
   {
-    localFail("page frame number not present, run this program as root\n");
+    size_t len = round_up(sz, HPAGE_SIZE);
+    // Over-map so the arena can start on a huge-page boundary
+    char* raw = static_cast<char*>(mmap(
+      nullptr,
+      len + HPAGE_SIZE,
+      PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+      -1,
+      0));
+    if (raw == MAP_FAILED)
+      localFail("could not map %zu bytes: %s\n", len, strerror(errno));
+    char* addr = reinterpret_cast<char*>(
+      round_up(reinterpret_cast<uintptr_t>(raw), HPAGE_SIZE));
+    if (addr != raw)
+      munmap(raw, addr - raw);
+    munmap(addr + len, raw + HPAGE_SIZE - addr);
+    madvise(addr, len, MADV_HUGEPAGE);
+    return {addr, len, PAGE_SIZE};
   }
 
-  uint64_t flags;
-  if (
-    pread(kpageflags_fd, &flags, sizeof(flags), PAGEMAP_PFN(ent) << 3) !=
-    sizeof(flags))
+  inline bool map_hugetlb(size_t sz, size_t page, Mapping& m)
   {
-    localFail("could not read from kpageflags\n");
+    int shift = page == GPAGE_SIZE ? 30 : 21;
+    size_t len = round_up(sz, page);
+    void* p = mmap(
+      nullptr,
+      len,
+      PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (shift << MAP_HUGE_SHIFT),
+      -1,
+      0);
+    if (p == MAP_FAILED)
+    {
+      fprintf(
+        stderr,
+        "hugepages: no %zu MiB %s pages (%s)\n",
+        len >> 20,
+        page == GPAGE_SIZE ? "1 GiB" : "2 MiB",
+        strerror(errno));
+      return false;
+    }
+    m = {static_cast<char*>(p), len, page};
+    return true;
   }
 
-  if (!(flags & (1ull << KPF_THP)))
+  inline bool map_hugetlbfs(size_t sz, const std::string& dir, Mapping& m)
   {
-    localFail("could not allocate huge page\n");
+    struct statfs fs;
+    if (statfs(dir.c_str(), &fs) != 0)
+    {
+      fprintf(stderr, "hugepages: %s: %s\n", dir.c_str(), strerror(errno));
+      return false;
+    }
+    size_t page = fs.f_bsize;
+    size_t len = round_up(sz, page);
+    std::string path = dir + "/doradd-XXXXXX";
+    int fd = mkstemp(path.data());
+    if (fd < 0)
+    {
+      fprintf(stderr, "hugepages: %s: %s\n", path.c_str(), strerror(errno));
+      return false;
+    }
+    unlink(path.c_str());
+    void* p = MAP_FAILED;
+    if (ftruncate(fd, len) == 0)
+      p = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED)
+    {
+      fprintf(
+        stderr,
+        "hugepages: no %zu MiB on %s (%s)\n",
+        len >> 20,
+        dir.c_str(),
+        strerror(errno));
+      return false;
+    }
+    m = {static_cast<char*>(p), len, page};
+    return true;
   }
 
-  if (close(pagemap_fd) < 0)
+  // Maps at least `sz` bytes from the configured source, falling back
+  // towards THP. Nothing is faulted in yet, so a NUMA policy can still be
+  // applied to the range.
+  inline Mapping map(size_t sz)
   {
-    localFail("could not close /proc/self/pagemap: %s", strerror(errno));
+    auto& cfg = Config::instance();
+    Mapping m;
+    switch (cfg.source)
+    {
+      case Source::HUGETLBFS:
+        if (map_hugetlbfs(sz, cfg.dir, m))
+          return m;
+        [[fallthrough]];
+      case Source::HUGETLB_1G:
+        if (cfg.source != Source::HUGETLBFS && map_hugetlb(sz, GPAGE_SIZE, m))
+          return m;
+        [[fallthrough]];
+      case Source::HUGETLB_2M:
+        if (map_hugetlb(sz, HPAGE_SIZE, m))
+          return m;
+        fprintf(stderr, "hugepages: falling back to THP\n");
+        [[fallthrough]];
+      case Source::THP:
+        break;
+    }
+    return map_thp(sz);
   }
-  if (close(kpageflags_fd) < 0)
+
+  // Touches one byte per page of [begin, end) from one thread per entry of
+  // `cpus`, pinned there, or from one unpinned thread per CPU if empty
+  inline void prefault(
+    char* begin, char* end, size_t page, const std::vector<int>& cpus = {})
   {
-    localFail("could not close /proc/kpageflags: %s", strerror(errno));
+    size_t pages = (end - begin) / page;
+    size_t nthreads = cpus.empty() ? std::thread::hardware_concurrency() :
+                                     cpus.size();
+    nthreads = std::max<size_t>(1, std::min(nthreads, pages));
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < nthreads; t++)
+    {
+      threads.emplace_back([=, &cpus]() {
+        if (!cpus.empty())
+          pin_thread(cpus[t]);
+        for (size_t p = pages * t / nthreads; p < pages * (t + 1) / nthreads;
+             p++)
+          *reinterpret_cast<volatile char*>(begin + p * page) = 0;
+      });
+    }
+    for (auto& t : threads)
+      t.join();
   }
-}
-
-void* aligned_alloc_hpage_fd(int fd)
-{
-  // printf("using hpage: %d\n", HPAGE_SIZE);
-  struct stat sb;
-  fstat(fd, &sb);
 
-  size_t src_sz = sb.st_size;
-  size_t hpage_nr = (size_t)(src_sz / HPAGE_SIZE) + 1;
-  size_t alloc_sz = hpage_nr * HPAGE_SIZE;
-
-  // printf("src_sz: %zu, hpage_nr: %zu, alloc_sz: %zu\n",
-  // src_sz, hpage_nr, alloc_sz);
-  void* buf = aligned_alloc(HPAGE_SIZE, alloc_sz);
-  if (!buf)
-    printf("could not allocate mem for mmap: %s\n", strerror(errno));
-
-  void* buf_begin = buf;
-  madvise(buf, alloc_sz, MADV_HUGEPAGE | MADV_SEQUENTIAL);
-
-  char* src = reinterpret_cast<char*>(
-    mmap(nullptr, src_sz, PROT_READ, MAP_PRIVATE, fd, 0));
-
-  char* src_begin = src;
-  for (size_t i = 0; i < hpage_nr - 1; i++)
+  // Bytes of [addr, addr + len) backed by huge pages, from /proc/self/smaps
+  inline size_t huge_bytes(const char* addr, size_t len)
   {
-    memcpy(buf, src, HPAGE_SIZE);
-    // check_huge_page(buf);
-    buf += HPAGE_SIZE;
-    src += HPAGE_SIZE;
+    FILE* f = fopen("/proc/self/smaps", "r");
+    if (!f)
+      return 0;
+    uintptr_t lo = reinterpret_cast<uintptr_t>(addr), hi = lo + len;
+    bool inside = false;
+    size_t huge = 0;
+    char line[512];
+    while (fgets(line, sizeof(line), f))
+    {
+      uintptr_t start, end;
+      size_t kb;
+      if (sscanf(line, "%lx-%lx", &start, &end) == 2)
+        inside = start < hi && lo < end;
+      else if (!inside)
+        continue;
+      else if (
+        sscanf(line, "AnonHugePages: %zu kB", &kb) == 1 ||
+        sscanf(line, "Private_Hugetlb: %zu kB", &kb) == 1 ||
+        sscanf(line, "Shared_Hugetlb: %zu kB", &kb) == 1)
+        huge += kb << 10;
+    }
+    fclose(f);
+    return std::min(huge, len);
   }
 
-  memcpy(buf, src, strlen(src));
-  printf("allocated huge pages\n");
+  // Prints how the arena is backed; warns if huge pages do not cover it
+  inline void report(const Mapping& m, std::chrono::steady_clock::time_point t0)
+  {
+    double secs =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - t0)
+        .count();
+    double covered = static_cast<double>(huge_bytes(m.addr, m.len)) / m.len;
+    const char* kind = m.page == PAGE_SIZE ? "THP" :
+      m.page == GPAGE_SIZE                 ? "1 GiB pages" :
+                                             "2 MiB pages";
+    printf(
+      "allocated huge pages: %zu MiB of %s, %.1f%% huge, %.2f s\n",
+      m.len >> 20,
+      kind,
+      100 * covered,
+      secs);
+    if (covered < 0.99)
+      fprintf(
+        stderr, "hugepages: only %.1f%% of the arena is huge\n", 100 * covered);
+  }
 
-  munmap(src_begin, src_sz);
-  return buf_begin;
+  // Maps and pre-faults an arena of at least `sz` bytes
+  inline char* alloc(size_t sz)
+  {
+    auto t0 = std::chrono::steady_clock::now();
+    Mapping m = map(sz);
+    prefault(m.addr, m.addr + m.len, m.page);
+    report(m, t0);
+    return m.addr;
+  }
 }
 
 void* aligned_alloc_hpage(size_t sz)
 {
-  size_t hpage_nr = (size_t)(sz / HPAGE_SIZE) + 1;
-  size_t alloc_sz = hpage_nr * HPAGE_SIZE;
-
-  void* buf = aligned_alloc(HPAGE_SIZE, alloc_sz);
-  if (!buf)
-    printf("could not allocate mem for mmap: %s\n", strerror(errno));
-
-  void* buf_begin = buf;
-  madvise(buf, alloc_sz, MADV_HUGEPAGE);
-
-  for (size_t i = 0; i < hpage_nr; i++)
-  {
-    memset(buf, 0, HPAGE_SIZE);
-    check_huge_page(buf);
-    buf += HPAGE_SIZE;
-  }
-  printf("allocated huge pages\n");
-  return buf_begin;
+  return hpage::alloc(sz);
 }
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "hugepage.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// Transaction input log.
+//
+// A log is a uint32_t record count followed by that many fixed-size
+// marshalled transactions. The stages replay it in place, and the Indexer
+// writes each record's cown addresses into it, so the whole file is read
+// into a private huge-page buffer (from the --hugepages source) by several
+// threads with pread(): every page is faulted in by the reader that fills
+// it, before the pipeline starts, and the Indexer's writes hit memory that
+// is already private. A MAP_PRIVATE mapping of the file instead took a
+// copy-on-write fault per 4 KiB page on the first write of the run.
+namespace input_log
+{
+  // Bytes each reader claims per pread() round
+  static constexpr size_t READ_CHUNK = 64ul << 20;
+
+  struct Log
+  {
+    char* buf; // header, then `count` records
+    uint32_t count;
+    size_t record;
+  };
+
+  // Fills buf[off, off + len) from `fd`
+  inline void
+  read_range(int fd, const char* path, char* buf, size_t off, size_t len)
+  {
+    while (len > 0)
+    {
+      ssize_t n = pread(fd, buf + off, len, off);
+      if (n < 0 && errno == EINTR)
+        continue;
+      if (n <= 0)
+        localFail(
+          "%s: read at %zu: %s\n", path, off, n < 0 ? strerror(errno) : "EOF");
+      off += n;
+      len -= n;
+    }
+  }
+
+  // Loads the log at `path`, whose records are `record` bytes, on up to
+  // `threads` threads (0: one per CPU). Exits if the header count and the
+  // file size disagree.
+  inline Log load(const char* path, size_t record, size_t threads = 0)
+  {
+    auto t0 = std::chrono::steady_clock::now();
+    int fd = open(path, O_RDONLY);
+    if (fd == -1)
+      localFail("%s: %s\n", path, strerror(errno));
+    struct stat sb;
+    if (fstat(fd, &sb) != 0)
+      localFail("%s: %s\n", path, strerror(errno));
+    size_t size = sb.st_size;
+
+    uint32_t count;
+    if (size < sizeof(count))
+      localFail("%s: %zu bytes, too short for a log header\n", path, size);
+    read_range(fd, path, reinterpret_cast<char*>(&count), 0, sizeof(count));
+    size_t need = sizeof(count) + static_cast<size_t>(count) * record;
+    if (count == 0 || size < need)
+      localFail(
+        "%s: header says %u records of %zu bytes (%zu bytes), file has %zu\n",
+        path,
+        count,
+        record,
+        need,
+        size);
+    if (size > need)
+      fprintf(
+        stderr,
+        "%s: ignoring %zu bytes after the last of %u records\n",
+        path,
+        size - need,
+        count);
+
+    hpage::Mapping m = hpage::map(need);
+    size_t chunks = (need + READ_CHUNK - 1) / READ_CHUNK;
+    if (threads == 0)
+      threads = std::thread::hardware_concurrency();
+    threads = std::max<size_t>(1, std::min(threads, chunks));
+    std::vector<std::thread> readers;
+    for (size_t t = 0; t < threads; t++)
+    {
+      readers.emplace_back([=, &m]() {
+        for (size_t c = t; c < chunks; c += threads)
+        {
+          size_t off = c * READ_CHUNK;
+          read_range(fd, path, m.addr, off, std::min(READ_CHUNK, need - off));
+        }
+      });
+    }
+    for (auto& r : readers)
+      r.join();
+    close(fd);
+
+    hpage::report(m, t0);
+    printf(
+      "input log: %u records of %zu bytes from %s on %zu threads\n",
+      count,
+      record,
+      path,
+      threads);
+    return {m.addr, count, record};
+  }
+}
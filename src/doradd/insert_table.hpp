@@ -0,0 +1,196 @@
+#pragma once
+
+#include "hugepage.hpp"
+#include "stride_table.hpp"
+
+#include <atomic>
+#include <cpp/when.h>
+#include <new>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+using namespace verona::rt;
+using namespace verona::cpp;
+
+// Table for rows that transactions insert while the system runs.
+//
+// Keys map to cown addresses through open addressing with linear probing,
+// lock free: an insert claims a slot by CAS on its key and then publishes
+// the row address. The table is split into levels; level i holds
+// `initial << i` slots and is mapped when an insert first finds no free
+// slot within MAX_PROBE of its home in every existing level, so the table
+// grows without ever moving an entry. Lookups probe the levels in order
+// and stop at the first empty slot, since entries are never removed.
+//
+// Rows are carved from per-thread slabs of huge-page memory, row_stride()
+// bytes apart, so concurrent inserters never share an allocator or a cache
+// line, and a worker's new rows stay on its NUMA node. Rows live as long
+// as the process, like the rows in a StrideTable.
+//
+// TPCC packs (w_id, d_id, o_id[, number]) densely into keys, so scan()
+// walks a key range in key order with one lookup per key.
+template<typename T>
+class InsertTable
+{
+public:
+  static constexpr size_t MAX_LEVELS = 32;
+  static constexpr size_t MAX_PROBE = 64;
+  static constexpr size_t SLAB_BYTES = HPAGE_SIZE;
+
+  // `initial` slots in the first level, rounded up to a power of two
+  explicit InsertTable(size_t initial)
+  {
+    while (first < initial)
+      first <<= 1;
+  }
+
+  static constexpr size_t stride()
+  {
+    return row_stride<T>();
+  }
+
+  // Creates row `key` from `args` and returns its cown address. A second
+  // insert of the same key replaces the row the key resolves to.
+  template<typename... Args>
+  uint64_t insert(uint64_t key, Args&&... args)
+  {
+    void* slot = alloc();
+    cown_ptr<T> c = make_cown_custom<T>(slot, std::forward<Args>(args)...);
+    uint64_t addr = c.get_base_addr();
+    leak_cown(std::move(c));
+
+    for (size_t l = 0; l < MAX_LEVELS; l++)
+    {
+      Entry* level = get_level(l);
+      size_t mask = (first << l) - 1;
+      size_t h = home(key, l);
+      for (size_t i = 0; i < MAX_PROBE; i++, h = (h + 1) & mask)
+      {
+        Entry& e = level[h];
+        uint64_t k = e.key.load(std::memory_order_acquire);
+        if (k == EMPTY &&
+            e.key.compare_exchange_strong(
+              k, key + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+          e.addr.store(addr, std::memory_order_release);
+          rows.fetch_add(1, std::memory_order_relaxed);
+          return addr;
+        }
+        if (k == key + 1)
+        {
+          e.addr.store(addr, std::memory_order_release);
+          return addr;
+        }
+      }
+    }
+    fprintf(stderr, "InsertTable: no free slot for key %lu\n", key);
+    abort();
+  }
+
+  // Cown address of row `key`, or 0 if it was never inserted
+  uint64_t get_base_addr(uint64_t key) const
+  {
+    for (size_t l = 0; l < MAX_LEVELS; l++)
+    {
+      Entry* level = levels[l].load(std::memory_order_acquire);
+      if (!level)
+        return 0;
+      size_t mask = (first << l) - 1;
+      size_t h = home(key, l);
+      for (size_t i = 0; i < MAX_PROBE; i++, h = (h + 1) & mask)
+      {
+        const Entry& e = level[h];
+        uint64_t k = e.key.load(std::memory_order_acquire);
+        if (k == EMPTY)
+          return 0;
+        if (k == key + 1)
+        {
+          // The inserter claimed the slot but may not have published yet
+          uint64_t addr;
+          while ((addr = e.addr.load(std::memory_order_acquire)) == 0)
+            ;
+          return addr;
+        }
+      }
+    }
+    return 0;
+  }
+
+  cown_ptr<T> get_row(uint64_t key) const
+  {
+    return get_cown_ptr_from_addr<T>(
+      reinterpret_cast<void*>(get_base_addr(key)));
+  }
+
+  // Calls fn(key, addr) for every row in [lo, hi), in key order
+  template<typename F>
+  void scan(uint64_t lo, uint64_t hi, F&& fn) const
+  {
+    for (uint64_t k = lo; k < hi; k++)
+      if (uint64_t addr = get_base_addr(k))
+        fn(k, addr);
+  }
+
+  uint64_t size() const
+  {
+    return rows.load(std::memory_order_relaxed);
+  }
+
+private:
+  static constexpr uint64_t EMPTY = 0; // keys are stored plus one
+
+  struct Entry
+  {
+    std::atomic<uint64_t> key;
+    std::atomic<uint64_t> addr;
+  };
+
+  struct Slab
+  {
+    char* next = nullptr;
+    char* end = nullptr;
+  };
+
+  size_t first = 64;
+  std::atomic<Entry*> levels[MAX_LEVELS] = {};
+  std::atomic<uint64_t> rows{0};
+
+  size_t home(uint64_t key, size_t level) const
+  {
+    // Fibonacci hashing: the top bits of the product spread the dense TPCC
+    // keys over the level
+    size_t bits = __builtin_ctzll(first) + level;
+    return (key * 0x9e3779b97f4a7c15ull) >> (64 - bits);
+  }
+
+  // Level `l`, mapped by whichever inserter needs it first. Anonymous
+  // mappings come zeroed, which is an empty level.
+  Entry* get_level(size_t l)
+  {
+    Entry* level = levels[l].load(std::memory_order_acquire);
+    if (level)
+      return level;
+    size_t bytes = (first << l) * sizeof(Entry);
+    Entry* fresh = reinterpret_cast<Entry*>(hpage::map_thp(bytes).addr);
+    if (levels[l].compare_exchange_strong(
+          level, fresh, std::memory_order_acq_rel, std::memory_order_acquire))
+      return fresh;
+    munmap(fresh, hpage::round_up(bytes, HPAGE_SIZE));
+    return level;
+  }
+
+  static void* alloc()
+  {
+    static thread_local Slab slab;
+    if (slab.next == slab.end)
+    {
+      hpage::Mapping m = hpage::map_thp(SLAB_BYTES);
+      slab.next = m.addr;
+      slab.end = m.addr + m.len / stride() * stride();
+    }
+    void* row = slab.next;
+    slab.next += stride();
+    return row;
+  }
+};
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Log-linear latency histogram in the style of HdrHistogram. Values below
+// 2^SUB_BUCKET_BITS ns get their own bucket; above that every power of two is
+// split into 2^SUB_BUCKET_BITS buckets, so the relative error is below
+// 1 / 2^SUB_BUCKET_BITS (~3%) across the whole range.
+//
+// Each histogram has a single writer (its worker thread), which updates
+// counts with plain relaxed load/store, so recording is a handful of
+// instructions with no atomic RMW and no allocation. Readers may merge it
+// concurrently and see slightly stale counts.
+struct alignas(64) LatencyHistogram
+{
+  static constexpr uint32_t SUB_BUCKET_BITS = 5;
+  static constexpr uint32_t SUB_BUCKETS = 1u << SUB_BUCKET_BITS;
+  static constexpr uint32_t MAX_BITS = 42; // ~73 min in ns
+  static constexpr uint32_t NUM_BUCKETS =
+    (MAX_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+  std::array<std::atomic<uint64_t>, NUM_BUCKETS> counts{};
+  std::atomic<uint64_t> max_ns{0};
+
+  static uint32_t bucket_of(uint64_t v)
+  {
+    if (v < SUB_BUCKETS)
+      return static_cast<uint32_t>(v);
+    uint32_t msb = 63 - __builtin_clzll(v);
+    if (msb >= MAX_BITS)
+      return NUM_BUCKETS - 1;
+    uint32_t shift = msb - SUB_BUCKET_BITS;
+    return (shift + 1) * SUB_BUCKETS +
+      static_cast<uint32_t>((v >> shift) - SUB_BUCKETS);
+  }
+
+  // Highest value that lands in bucket `b`
+  static uint64_t bucket_upper(uint32_t b)
+  {
+    if (b < SUB_BUCKETS)
+      return b;
+    uint32_t shift = b / SUB_BUCKETS - 1;
+    uint64_t sub = b % SUB_BUCKETS + SUB_BUCKETS;
+    return ((sub + 1) << shift) - 1;
+  }
+
+  void record(uint64_t ns)
+  {
+    auto& c = counts[bucket_of(ns)];
+    c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (ns > max_ns.load(std::memory_order_relaxed))
+      max_ns.store(ns, std::memory_order_relaxed);
+  }
+};
+
+// Owns one histogram per recording thread, merges them for the periodic
+// reporter and dumps them in binary at the end of a run.
+class LatencyHistograms
+{
+public:
+  using Counts = std::array<uint64_t, LatencyHistogram::NUM_BUCKETS>;
+
+  static LatencyHistograms& instance()
+  {
+    static LatencyHistograms h;
+    return h;
+  }
+
+  // Called once per thread; the histogram lives until the process exits
+  LatencyHistogram* register_thread()
+  {
+    auto* h = new LatencyHistogram();
+    std::lock_guard<std::mutex> lock(mu);
+    histograms.push_back(h);
+    return h;
+  }
+
+  uint64_t merge(Counts& out)
+  {
+    out.fill(0);
+    uint64_t max = 0;
+    std::lock_guard<std::mutex> lock(mu);
+    for (auto* h : histograms)
+    {
+      for (uint32_t b = 0; b < LatencyHistogram::NUM_BUCKETS; b++)
+        out[b] += h->counts[b].load(std::memory_order_relaxed);
+      max = std::max(max, h->max_ns.load(std::memory_order_relaxed));
+    }
+    return max;
+  }
+
+  static uint64_t percentile(const Counts& c, uint64_t total, double p)
+  {
+    uint64_t rank = static_cast<uint64_t>(p * total);
+    uint64_t seen = 0;
+    for (uint32_t b = 0; b < LatencyHistogram::NUM_BUCKETS; b++)
+    {
+      seen += c[b];
+      if (seen > rank)
+        return LatencyHistogram::bucket_upper(b);
+    }
+    return 0;
+  }
+
+  // Prints p50/p99/p999/max of the transactions completed in each interval
+  void start_reporter(std::chrono::milliseconds interval)
+  {
+    reporter = std::thread([this, interval]() {
+      auto prev = std::make_unique<Counts>();
+      auto cur = std::make_unique<Counts>();
+      auto delta = std::make_unique<Counts>();
+      prev->fill(0);
+      while (!stop.load(std::memory_order_relaxed))
+      {
+        std::this_thread::sleep_for(interval);
+        merge(*cur);
+        uint64_t total = 0;
+        uint32_t top = 0;
+        for (uint32_t b = 0; b < LatencyHistogram::NUM_BUCKETS; b++)
+        {
+          (*delta)[b] = (*cur)[b] - (*prev)[b];
+          total += (*delta)[b];
+          if ((*delta)[b])
+            top = b;
+        }
+        std::swap(prev, cur);
+        if (total == 0)
+          continue;
+        printf(
+          "latency - n=%lu p50=%.1fus p99=%.1fus p999=%.1fus max=%.1fus\n",
+          total,
+          percentile(*delta, total, 0.50) / 1e3,
+          percentile(*delta, total, 0.99) / 1e3,
+          percentile(*delta, total, 0.999) / 1e3,
+          LatencyHistogram::bucket_upper(top) / 1e3);
+      }
+    });
+  }
+
+  void stop_reporter()
+  {
+    stop.store(true, std::memory_order_relaxed);
+    if (reporter.joinable())
+      reporter.join();
+  }
+
+  // Layout: u32 magic, u32 sub-bucket bits, u32 bucket count, u32 thread
+  // count, then per thread u64 max_ns and u64 counts[bucket count]
+  bool dump(const char* path)
+  {
+    FILE* f = fopen(path, "wb");
+    if (!f)
+      return false;
+    std::lock_guard<std::mutex> lock(mu);
+    uint32_t header[4] = {
+      DUMP_MAGIC,
+      LatencyHistogram::SUB_BUCKET_BITS,
+      LatencyHistogram::NUM_BUCKETS,
+      static_cast<uint32_t>(histograms.size())};
+    fwrite(header, sizeof(header), 1, f);
+    std::vector<uint64_t> buf(LatencyHistogram::NUM_BUCKETS + 1);
+    for (auto* h : histograms)
+    {
+      buf[0] = h->max_ns.load(std::memory_order_relaxed);
+      for (uint32_t b = 0; b < LatencyHistogram::NUM_BUCKETS; b++)
+        buf[b + 1] = h->counts[b].load(std::memory_order_relaxed);
+      fwrite(buf.data(), sizeof(uint64_t), buf.size(), f);
+    }
+    return fclose(f) == 0;
+  }
+
+  static constexpr uint32_t DUMP_MAGIC = 0x4c415448; // "LATH"
+
+private:
+  std::mutex mu;
+  std::vector<LatencyHistogram*> histograms;
+  std::thread reporter;
+  std::atomic<bool> stop{false};
+};
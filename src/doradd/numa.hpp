@@ -0,0 +1,262 @@
+#pragma once
+
+#include "hugepage.hpp"
+#include "pin-thread.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <errno.h>
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// NUMA placement for the row arenas and the workers that touch them.
+//
+//   --numa local|interleave|partition|bind:<node>  [--numa-workers <node>]
+//
+// local (the default) keeps the whole arena on the main thread's node,
+// interleave spreads huge pages round-robin over all nodes, partition gives
+// each node one contiguous slice of the arena (rows are laid out by key, so
+// each node owns a key range) and bind puts everything on one node. The
+// policy is set with mbind() before any page is touched, and the pages are
+// then pre-faulted in parallel by threads pinned to the node that owns
+// them. Pages come from the --hugepages source (see hugepage.hpp).
+//
+// --numa-workers restricts the calling thread to one node's CPUs before
+// the scheduler starts, so the workers it spawns inherit that placement,
+// and moves the pinned pipeline threads (Indexer, Prefetcher, Spawner, RPC
+// handler) onto the same node; comparing bind:<same node> with bind:<other node> or interleave then
+// measures what placement is worth.
+namespace numa
+{
+  enum class Placement
+  {
+    LOCAL,
+    INTERLEAVE,
+    PARTITION,
+    BIND
+  };
+
+  struct Node
+  {
+    int id;
+    std::vector<int> cpus;
+  };
+
+  // Parses a sysfs list such as "0-15,32-47"
+  inline std::vector<int> parse_list(const char* path)
+  {
+    std::vector<int> out;
+    FILE* f = fopen(path, "r");
+    if (!f)
+      return out;
+    char buf[4096];
+    if (fgets(buf, sizeof(buf), f))
+    {
+      for (char* tok = strtok(buf, ",\n"); tok; tok = strtok(nullptr, ",\n"))
+      {
+        int lo, hi;
+        int n = sscanf(tok, "%d-%d", &lo, &hi);
+        if (n == 1)
+          hi = lo;
+        for (int i = lo; n >= 1 && i <= hi; i++)
+          out.push_back(i);
+      }
+    }
+    fclose(f);
+    return out;
+  }
+
+  inline const std::vector<Node>& nodes()
+  {
+    static std::vector<Node> all = []() {
+      std::vector<Node> v;
+      for (int id : parse_list("/sys/devices/system/node/online"))
+      {
+        std::string path =
+          "/sys/devices/system/node/node" + std::to_string(id) + "/cpulist";
+        v.push_back({id, parse_list(path.c_str())});
+      }
+      if (v.empty())
+      {
+        // No sysfs topology: one node with every CPU
+        Node n{0, {}};
+        for (unsigned c = 0; c < std::thread::hardware_concurrency(); c++)
+          n.cpus.push_back(static_cast<int>(c));
+        v.push_back(n);
+      }
+      return v;
+    }();
+    return all;
+  }
+
+  inline const Node* find_node(int id)
+  {
+    for (auto& n : nodes())
+      if (n.id == id)
+        return &n;
+    return nullptr;
+  }
+
+  class Config
+  {
+  public:
+    Placement placement = Placement::LOCAL;
+    int bind_node = 0;
+    int worker_node = -1;
+
+    static Config& instance()
+    {
+      static Config c;
+      return c;
+    }
+
+    void parse_args(int argc, char** argv)
+    {
+      for (int i = 1; i + 1 < argc; i++)
+      {
+        if (strcmp(argv[i], "--numa") == 0)
+        {
+          const char* p = argv[++i];
+          if (strcmp(p, "local") == 0)
+            placement = Placement::LOCAL;
+          else if (strcmp(p, "interleave") == 0)
+            placement = Placement::INTERLEAVE;
+          else if (strcmp(p, "partition") == 0)
+            placement = Placement::PARTITION;
+          else if (sscanf(p, "bind:%d", &bind_node) == 1)
+            placement = Placement::BIND;
+          else
+          {
+            fprintf(stderr, "Unknown --numa policy %s\n", p);
+            exit(1);
+          }
+        }
+        else if (strcmp(argv[i], "--numa-workers") == 0)
+          worker_node = atoi(argv[++i]);
+      }
+      if (placement == Placement::BIND && !find_node(bind_node))
+      {
+        fprintf(stderr, "NUMA node %d is not online\n", bind_node);
+        exit(1);
+      }
+      if (worker_node >= 0 && !find_node(worker_node))
+      {
+        fprintf(stderr, "NUMA node %d is not online\n", worker_node);
+        exit(1);
+      }
+    }
+
+    // Restricts the calling thread, and the threads it creates from now
+    // on, to the CPUs of --numa-workers
+    void place_workers() const
+    {
+      if (worker_node < 0)
+        return;
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      for (int c : find_node(worker_node)->cpus)
+        CPU_SET(c, &set);
+      if (sched_setaffinity(0, sizeof(set), &set) != 0)
+        perror("numa: sched_setaffinity");
+      else
+        printf("numa: workers on node %d\n", worker_node);
+    }
+
+    // CPU for a pipeline thread whose default core is `cpu`: unchanged
+    // without --numa-workers, otherwise the same offset into the worker
+    // node's CPU list, so the default spacing between threads is kept
+    int dispatcher_cpu(int cpu) const
+    {
+      if (worker_node < 0)
+        return cpu;
+      const auto& cpus = find_node(worker_node)->cpus;
+      return cpus.empty() ? cpu : cpus[cpu % cpus.size()];
+    }
+  };
+
+  inline bool bind(void* addr, size_t len, int mode, const std::vector<int>& ids)
+  {
+    unsigned long mask[16] = {};
+    for (int id : ids)
+      mask[id / 64] |= 1ul << (id % 64);
+    long r = syscall(SYS_mbind, addr, len, mode, mask, 16 * 64 + 1, 0);
+    if (r != 0)
+      fprintf(stderr, "numa: mbind: %s\n", strerror(errno));
+    return r == 0;
+  }
+
+  // Node whose CPUs include the one the caller runs on
+  inline const Node& current_node()
+  {
+    int cpu = sched_getcpu();
+    for (auto& n : nodes())
+      if (std::find(n.cpus.begin(), n.cpus.end(), cpu) != n.cpus.end())
+        return n;
+    return nodes().front();
+  }
+
+  // Huge-page arena of at least `sz` bytes placed by the --numa policy
+  inline void* alloc_arena(size_t sz)
+  {
+    auto& cfg = Config::instance();
+    auto start = std::chrono::steady_clock::now();
+    hpage::Mapping m = hpage::map(sz);
+    char* buf = m.addr;
+    char* end = m.addr + m.len;
+    auto& all = nodes();
+    std::vector<int> ids;
+    std::vector<int> cpus;
+    for (auto& n : all)
+    {
+      ids.push_back(n.id);
+      cpus.insert(cpus.end(), n.cpus.begin(), n.cpus.end());
+    }
+
+    switch (cfg.placement)
+    {
+      case Placement::LOCAL:
+        hpage::prefault(buf, end, m.page, current_node().cpus);
+        break;
+      case Placement::INTERLEAVE:
+        bind(buf, m.len, MPOL_INTERLEAVE, ids);
+        hpage::prefault(buf, end, m.page, cpus);
+        break;
+      case Placement::PARTITION:
+      {
+        // Slices end on huge-page boundaries even when THP backs the arena
+        size_t unit = std::max<size_t>(m.page, HPAGE_SIZE);
+        size_t units = m.len / unit;
+        std::vector<std::thread> per_node;
+        for (size_t i = 0; i < all.size(); i++)
+        {
+          char* lo = buf + units * i / all.size() * unit;
+          char* hi = buf + units * (i + 1) / all.size() * unit;
+          if (lo == hi)
+            continue;
+          bind(lo, hi - lo, MPOL_BIND, {all[i].id});
+          per_node.emplace_back([lo, hi, page = m.page, &n = all[i]]() {
+            hpage::prefault(lo, hi, page, n.cpus);
+          });
+        }
+        for (auto& t : per_node)
+          t.join();
+        break;
+      }
+      case Placement::BIND:
+        bind(buf, m.len, MPOL_BIND, {cfg.bind_node});
+        hpage::prefault(buf, end, m.page, find_node(cfg.bind_node)->cpus);
+        break;
+    }
+
+    hpage::report(m, start);
+    return buf;
+  }
+}
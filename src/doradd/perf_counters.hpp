@@ -0,0 +1,261 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+// Hardware performance counters per pipeline stage and per worker, compiled
+// in with PERF_COUNTERS.
+//
+// Each stage thread and each verona worker opens one perf_event group on
+// itself (cycles, instructions, LLC / dTLB / L1D load misses). Groups are
+// created disabled; start() switches all of them on once transactions flow
+// and stop() switches them off before teardown, so warm-up and shutdown are
+// not counted. report() prints per-transaction averages for the interval
+// since the previous report, next to the spawner's throughput line.
+namespace perf
+{
+  enum Event
+  {
+    CYCLES,
+    INSTRUCTIONS,
+    LLC_LOAD_MISSES,
+    DTLB_LOAD_MISSES,
+    L1D_LOAD_MISSES,
+    NUM_EVENTS
+  };
+
+  static constexpr const char* EVENT_NAMES[NUM_EVENTS] = {
+    "cycles", "instructions", "llc-miss", "dtlb-miss", "l1d-miss"};
+
+  inline void event_attr(Event e, perf_event_attr& attr)
+  {
+    auto cache = [](uint64_t id) {
+      return id | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    };
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    switch (e)
+    {
+      case CYCLES:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CPU_CYCLES;
+        break;
+      case INSTRUCTIONS:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+        break;
+      case LLC_LOAD_MISSES:
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = cache(PERF_COUNT_HW_CACHE_LL);
+        break;
+      case DTLB_LOAD_MISSES:
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = cache(PERF_COUNT_HW_CACHE_DTLB);
+        break;
+      case L1D_LOAD_MISSES:
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = cache(PERF_COUNT_HW_CACHE_L1D);
+        break;
+      default:
+        break;
+    }
+  }
+
+  using Values = uint64_t[NUM_EVENTS];
+
+  // One counter group bound to the thread that opened it
+  class Group
+  {
+  public:
+    std::string name;
+
+    explicit Group(std::string name_) : name(std::move(name_))
+    {
+      for (int e = 0; e < NUM_EVENTS; e++)
+      {
+        perf_event_attr attr;
+        event_attr(static_cast<Event>(e), attr);
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+          PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attr.disabled = leader < 0;
+        int fd = static_cast<int>(
+          syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0));
+        if (fd < 0)
+        {
+          // Without the leader there is no group; a missing sibling just
+          // reads as zero
+          if (leader < 0)
+            return;
+          continue;
+        }
+        if (leader < 0)
+          leader = fd;
+        fds[num_open] = fd;
+        slot[num_open++] = e;
+      }
+    }
+
+    ~Group()
+    {
+      for (int i = 0; i < num_open; i++)
+        close(fds[i]);
+    }
+
+    bool ok() const
+    {
+      return leader >= 0;
+    }
+
+    void enable()
+    {
+      ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    void disable()
+    {
+      ioctl(leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    // Reads the group, scaled up if the kernel had to multiplex it
+    void read_values(Values& out)
+    {
+      uint64_t buf[3 + NUM_EVENTS] = {};
+      std::fill(out, out + NUM_EVENTS, 0);
+      if (::read(leader, buf, sizeof(buf)) <= 0)
+        return;
+      uint64_t nr = buf[0], enabled = buf[1], running = buf[2];
+      double scale = running ? static_cast<double>(enabled) / running : 0;
+      for (uint64_t i = 0; i < nr && i < static_cast<uint64_t>(num_open); i++)
+        out[slot[i]] = static_cast<uint64_t>(buf[3 + i] * scale);
+    }
+
+  private:
+    int leader = -1;
+    int num_open = 0;
+    int fds[NUM_EVENTS];
+    int slot[NUM_EVENTS];
+  };
+
+  class Registry
+  {
+  public:
+    static Registry& instance()
+    {
+      static Registry r;
+      return r;
+    }
+
+    // Opens a group on the calling thread
+    void attach(const char* name)
+    {
+      auto g = std::make_unique<Group>(name);
+      std::lock_guard<std::mutex> lock(mu);
+      if (!g->ok())
+      {
+        if (!warned)
+          fprintf(
+            stderr,
+            "perf: perf_event_open failed for %s (check "
+            "/proc/sys/kernel/perf_event_paranoid)\n",
+            name);
+        warned = true;
+        return;
+      }
+      if (running)
+        g->enable();
+      groups.push_back({std::move(g), {}});
+    }
+
+    void start()
+    {
+      std::lock_guard<std::mutex> lock(mu);
+      running = true;
+      for (auto& e : groups)
+      {
+        e.group->read_values(e.last);
+        e.group->enable();
+      }
+    }
+
+    void stop()
+    {
+      std::lock_guard<std::mutex> lock(mu);
+      running = false;
+      for (auto& e : groups)
+        e.group->disable();
+    }
+
+    // Prints per-transaction averages since the previous report. Stage
+    // groups are divided by `spawned`, the workers' sum by `executed`.
+    void report(uint64_t spawned, uint64_t executed)
+    {
+      std::lock_guard<std::mutex> lock(mu);
+      Values workers = {};
+      size_t num_workers = 0;
+      for (auto& e : groups)
+      {
+        Values now, delta;
+        e.group->read_values(now);
+        for (int i = 0; i < NUM_EVENTS; i++)
+        {
+          delta[i] = now[i] - std::min(now[i], e.last[i]);
+          e.last[i] = now[i];
+        }
+        if (e.group->name == "worker")
+        {
+          for (int i = 0; i < NUM_EVENTS; i++)
+            workers[i] += delta[i];
+          num_workers++;
+          continue;
+        }
+        print(e.group->name.c_str(), delta, spawned);
+      }
+      if (num_workers)
+      {
+        std::string name = "workers(" + std::to_string(num_workers) + ")";
+        print(name.c_str(), workers, executed ? executed : spawned);
+      }
+    }
+
+  private:
+    struct Entry
+    {
+      std::unique_ptr<Group> group;
+      Values last;
+    };
+
+    std::mutex mu;
+    std::vector<Entry> groups;
+    bool running = false;
+    bool warned = false;
+
+    static void print(const char* name, const Values& v, uint64_t txns)
+    {
+      if (txns == 0)
+        return;
+      double t = static_cast<double>(txns);
+      printf(
+        "perf  - %-12s cyc/tx=%.0f ipc=%.2f llc-miss/tx=%.2f "
+        "dtlb-miss/tx=%.2f l1d-miss/tx=%.2f\n",
+        name,
+        v[CYCLES] / t,
+        v[CYCLES] ? static_cast<double>(v[INSTRUCTIONS]) / v[CYCLES] : 0.0,
+        v[LLC_LOAD_MISSES] / t,
+        v[DTLB_LOAD_MISSES] / t,
+        v[L1D_LOAD_MISSES] / t);
+    }
+  };
+}
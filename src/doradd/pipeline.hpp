@@ -3,45 +3,52 @@
 #include "SPSCQueue.h"
 #include "config.hpp"
 #include "dispatcher.hpp"
+#include "input_log.hpp"
+#include "numa.hpp"
 #include "pin-thread.hpp"
 #include "rpc_handler.hpp"
-#include "../storage/rocksdb.hpp"
+#include "../storage/storage.hpp"
 #include "checkpointer.hpp"
 #include "txcounter.hpp"
+#include "perf_counters.hpp"
+#include "txn_trace.hpp"
+#include "timeline.hpp"
 
 #include <thread>
 #include <unordered_map>
 #include <filesystem>
 
-std::unordered_map<std::thread::id, uint64_t*>* counter_map;
 std::unordered_map<std::thread::id, log_arr_type*>* log_map;
-std::mutex* counter_map_mutex;
+std::mutex* log_map_mutex;
 
 // Global benchmark start time
 ts_type benchmark_start_time;
 
+// Where the checkpointer writes, and where recovery reads from
+constexpr const char* checkpoint_db_path = "/home/syl121/database/checkpoint.db";
+
 template<typename T>
 void build_pipelines(int worker_cnt, char* log_name, char* gen_type, int argc = 0, char** argv = nullptr)
 {
-  // init verona-rt scheduler
+  // init verona-rt scheduler; its workers inherit --numa-workers
+  const auto& numa_cfg = numa::Config::instance();
+  numa_cfg.place_workers();
   auto& sched = Scheduler::get();
   sched.init(worker_cnt + 1);
   when() << []() { std::cout << "Hello deterministic world!\n"; };
 
   // init stats collectors for workers
-  counter_map = new std::unordered_map<std::thread::id, uint64_t*>();
-  counter_map->reserve(worker_cnt);
+  WorkerCounters::instance().init(worker_cnt);
   log_map = new std::unordered_map<std::thread::id, log_arr_type*>();
   log_map->reserve(worker_cnt);
-  counter_map_mutex = new std::mutex();
+  log_map_mutex = new std::mutex();
 
   // Create storage instance and checkpointer
-  auto* checkpointer = new Checkpointer<RocksDBStore, T, typename T::RowType>("/home/syl121/database/checkpoint.db");
+  auto* checkpointer = new Checkpointer<CheckpointStore, T, typename T::RowType>(checkpoint_db_path);
   
   // Pass command line arguments to the checkpointer if available
   if (argc > 0 && argv != nullptr) {
     checkpointer->parse_args(argc, argv);
-    CheckpointStats::parse_args(argc, argv);
   }
 
   // init and run dispatcher pipelines
@@ -57,10 +64,9 @@ void build_pipelines(int worker_cnt, char* log_name, char* gen_type, int argc =
 
     // Init RPC handler
 #ifdef RPC_LATENCY
-    uint8_t* log_arr = static_cast<uint8_t*>(
-      aligned_alloc_hpage(RPC_LOG_SIZE * sizeof(ts_type)));
-
-    uint64_t log_arr_addr = (uint64_t)log_arr;
+    if (tsc::cycles_per_ns_fp == 0)
+      tsc::calibrate();
+    ArrivalLog* arrivals = new ArrivalLog(RPC_INFLIGHT_LOG_SIZE);
 
     std::string res_log_dir = "./results/";
     std::string res_log_suffix = "-latency.log";
@@ -68,45 +74,82 @@ void build_pipelines(int worker_cnt, char* log_name, char* gen_type, int argc =
     FILE* res_log_fd =
       fopen(reinterpret_cast<const char*>(res_log_name.c_str()), "w");
 
-    RPCHandler rpc_handler(&req_cnt, gen_type, log_arr_addr);
+    RPCHandler rpc_handler(&req_cnt, gen_type, arrivals);
 #else
     RPCHandler rpc_handler(&req_cnt, gen_type);
 #endif // RPC_LATENCY
 
-    // Map txn logs into memory
-    int fd = open(log_name, O_RDONLY);
-    if (fd == -1)
+    Sweep sweep(argc, argv);
+    if (sweep.enabled())
     {
-      printf("File not existed\n");
-      exit(1);
+      std::filesystem::create_directories("results");
+      sweep.open(std::string("results/") + gen_type + "-sweep.json");
+      rpc_handler.attach(&sweep);
     }
-    struct stat sb;
-    fstat(fd, &sb);
-    void* ret = reinterpret_cast<char*>(mmap(
-      nullptr,
-      sb.st_size,
-      PROT_READ | PROT_WRITE,
-      MAP_PRIVATE | MAP_POPULATE,
-      fd,
-      0));
+
+#if defined(LOG_LATENCY) && !defined(LOG_SCHED_OHEAD)
+    LatencyHistograms::instance().start_reporter(std::chrono::seconds(1));
+#endif
+
+#ifdef STAGE_TELEMETRY
+    telemetry::Registry::instance().start_sampler();
+#endif
+
+    timeline::Timeline::instance().start_sampler(
+      [checkpointer]() { return checkpointer->get_total_transactions(); },
+      []() { return WorkerCounters::instance().executed(); },
+#if defined(LOG_LATENCY) && !defined(LOG_SCHED_OHEAD)
+      [prev = std::make_shared<LatencyHistograms::Counts>(),
+       cur = std::make_shared<LatencyHistograms::Counts>()](uint64_t(&p)[3]) {
+        // Percentiles of the transactions completed since the last sample
+        LatencyHistograms::instance().merge(*cur);
+        uint64_t total = 0;
+        for (size_t b = 0; b < cur->size(); b++)
+        {
+          std::swap((*cur)[b], (*prev)[b]);
+          (*cur)[b] = (*prev)[b] - (*cur)[b];
+          total += (*cur)[b];
+        }
+        if (total == 0)
+          return false;
+        p[0] = LatencyHistograms::percentile(*cur, total, 0.50);
+        p[1] = LatencyHistograms::percentile(*cur, total, 0.99);
+        p[2] = LatencyHistograms::percentile(*cur, total, 0.999);
+        return true;
+      }
+#else
+      nullptr
+#endif
+    );
+
+#ifdef TXN_TRACE
+    std::filesystem::create_directories("results");
+    std::string trace_name = std::string("results/") + gen_type + "-txn.trace";
+    txn_trace::Tracer::instance().start(trace_name.c_str());
+#endif
+
+    // Read txn logs into huge pages before any stage touches them
+    input_log::Log log = input_log::load(log_name, T::MarshalledSize);
+    void* ret = log.buf;
 
     // Init dispatcher, prefetcher, and spawner
 #ifndef CORE_PIPE
     FileDispatcher<T> dispatcher(
       ret,
       worker_cnt,
-      counter_map,
-      counter_map_mutex,
       &req_cnt
 #  ifdef RPC_LATENCY
       ,
-      log_arr_addr
+      arrivals
 #  endif
     );
 
     std::thread extern_thrd([&]() mutable {
-      pin_thread(2);
+      pin_thread(numa_cfg.dispatcher_cpu(2));
       std::this_thread::sleep_for(std::chrono::seconds(1));
+#ifdef PERF_COUNTERS
+      perf::Registry::instance().attach("dispatcher");
+#endif
       dispatcher.run();
     });
 #else
@@ -121,59 +164,74 @@ void build_pipelines(int worker_cnt, char* log_name, char* gen_type, int argc =
 #  if defined(INDEXER)
     Prefetcher<T> prefetcher(ret, &ring_pref_disp, &ring_idx_pref);
 #    ifdef RPC_LATENCY
-    // give init_time_log_arr to spawner. Needed for capturing in when.
+    // give the arrival log to spawner. Needed for capturing in when.
     Spawner<T> spawner(
       ret,
       worker_cnt,
-      counter_map,
-      counter_map_mutex,
       &ring_pref_disp,
       checkpointer,
-      log_arr_addr,
+      arrivals,
       res_log_fd);
 #    else
     Spawner<T> spawner(
       ret, 
-      worker_cnt, 
-      counter_map, 
-      counter_map_mutex, 
+      worker_cnt,
       &ring_pref_disp,
       checkpointer);
 #    endif // RPC_LATENCY
 #  else
     Prefetcher<T> prefetcher(ret, &ring_pref_disp);
     Spawner<T> spawner(
-      ret, worker_cnt, counter_map, counter_map_mutex, &ring_pref_disp);
+      ret, worker_cnt, &ring_pref_disp);
 #  endif // INDEXER
 
     std::thread spawner_thread([&]() mutable {
-      pin_thread(0);
+      pin_thread(numa_cfg.dispatcher_cpu(0));
       std::this_thread::sleep_for(std::chrono::seconds(1));
+#ifdef PERF_COUNTERS
+      perf::Registry::instance().attach("spawner");
+#endif
       spawner.run();
     });
     std::thread prefetcher_thread([&]() mutable {
-      pin_thread(2);
+      pin_thread(numa_cfg.dispatcher_cpu(2));
       std::this_thread::sleep_for(std::chrono::seconds(2));
+#ifdef PERF_COUNTERS
+      perf::Registry::instance().attach("prefetcher");
+#endif
       prefetcher.run();
     });
 #endif
 
 #ifdef INDEXER
     std::thread indexer_thread([&]() mutable {
-      pin_thread(4);
+      pin_thread(numa_cfg.dispatcher_cpu(4));
       std::this_thread::sleep_for(std::chrono::seconds(4));
+#ifdef PERF_COUNTERS
+      perf::Registry::instance().attach("indexer");
+#endif
       indexer.run();
     });
 #endif
 
     std::thread rpc_handler_thread([&]() mutable {
-      pin_thread(6);
+      pin_thread(numa_cfg.dispatcher_cpu(6));
       std::this_thread::sleep_for(std::chrono::seconds(6));
+#ifdef PERF_COUNTERS
+      perf::Registry::instance().attach("rpc_handler");
+#endif
       rpc_handler.run();
     });
 
     // flush latency logs
-    std::this_thread::sleep_for(std::chrono::seconds(300));
+    if (sweep.enabled())
+      sweep.wait();
+    else
+      std::this_thread::sleep_for(std::chrono::seconds(300));
+
+#ifdef PERF_COUNTERS
+    perf::Registry::instance().stop();
+#endif
 
 #ifdef CORE_PIPE
     pthread_cancel(spawner_thread.native_handle());
@@ -186,37 +244,45 @@ void build_pipelines(int worker_cnt, char* log_name, char* gen_type, int argc =
 #endif // CORE_PIPE
 
     pthread_cancel(rpc_handler_thread.native_handle());
+    rpc_handler.stop();
 
-    // Print checkpoint statistics before continuing
-    printf("Printing Checkpoint Statistics\n");
-    CheckpointStats::print_stats();
+    // Export checkpoint phases alongside throughput and latency samples
+    timeline::Timeline::instance().stop_sampler();
+    std::filesystem::create_directories("results");
+    std::string timeline_name =
+      std::string("results/") + gen_type + "-timeline.csv";
+    if (!timeline::Timeline::instance().export_csv(timeline_name.c_str()))
+      fprintf(stderr, "Failed to write %s\n", timeline_name.c_str());
 
 #ifdef LOG_LATENCY
     printf("flush latency stats\n");
-    
-    // Create results directory if it doesn't exist
-    std::filesystem::create_directories("results");
-    
-    // Write raw data to the specified file
-    CheckpointStats::write_raw_data("results/checkpoint_latency.csv");
 
+#  ifdef LOG_SCHED_OHEAD
     for (const auto& entry : *log_map)
     {
       if (entry.second)
       {
-#  ifdef LOG_SCHED_OHEAD
         for (std::tuple<uint32_t, uint32_t> value_tuple : *(entry.second))
           fprintf(
             res_log_fd,
             "%u %u\n",
             std::get<0>(value_tuple),
             std::get<1>(value_tuple));
-#  else
-        for (auto value : *(entry.second))
-          fprintf(res_log_fd, "%lu\n", value);
-#  endif // LOG_SCHED_OHEAD
       }
     }
+#  else
+    LatencyHistograms::instance().stop_reporter();
+    std::string hist_name = res_log_dir + gen_type + "-latency.hist";
+    if (!LatencyHistograms::instance().dump(hist_name.c_str()))
+      fprintf(stderr, "Failed to write %s\n", hist_name.c_str());
+#  endif // LOG_SCHED_OHEAD
+#endif
+
+#ifdef STAGE_TELEMETRY
+    telemetry::Registry::instance().stop_sampler();
+#endif
+#ifdef TXN_TRACE
+    txn_trace::Tracer::instance().stop();
 #endif
 
     // sched.remove_external_event_source();
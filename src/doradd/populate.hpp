@@ -0,0 +1,202 @@
+#pragma once
+
+#include "numa.hpp"
+#include "pin-thread.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Parallel database population.
+//
+//   --load-threads <n>   (default: every CPU the --numa policy allows)
+//
+// parallel_for() splits a key range into chunks and loads them on threads
+// pinned next to the memory the chunk's rows live in: under --numa partition
+// each node loads the same proportion of the range as it owns of the arena
+// (exact when the table has an arena to itself), under local and bind the
+// owning node's CPUs load everything, and under interleave every CPU does.
+// At most one thread runs per CPU. Threads claim chunks of their node's
+// share with one fetch_add, so uneven chunks balance out. Nodes with memory
+// but no CPUs (CXL, HBM) are loaded from elsewhere: under partition their
+// slice goes to the preceding node with CPUs (the pages still land on the
+// memory-only node, since the policy, not the loader, places them), and
+// under bind the calling thread's node loads it. install_all() checks that
+// every key of a table was created.
+//
+// Rows sit at arena + stride * key, so where a row ends up does not depend
+// on which thread creates it or when. Generators that draw random contents
+// seed their generator per unit (e.g. per warehouse) rather than per thread,
+// which keeps the contents identical for any --load-threads, including 1.
+namespace populate
+{
+  class Config
+  {
+  public:
+    size_t threads = 0; // 0: one per allowed CPU
+
+    static Config& instance()
+    {
+      static Config c;
+      return c;
+    }
+
+    void parse_args(int argc, char** argv)
+    {
+      for (int i = 1; i + 1 < argc; i++)
+        if (strcmp(argv[i], "--load-threads") == 0)
+          threads = static_cast<size_t>(atol(argv[++i]));
+    }
+  };
+
+  // Part of a key range and the CPUs that load it
+  struct Share
+  {
+    std::vector<int> cpus;
+    uint64_t lo, hi;
+  };
+
+  inline std::vector<Share> shares(uint64_t begin, uint64_t end)
+  {
+    auto& cfg = numa::Config::instance();
+    auto& all = numa::nodes();
+    switch (cfg.placement)
+    {
+      case numa::Placement::LOCAL:
+        return {{numa::current_node().cpus, begin, end}};
+      case numa::Placement::BIND:
+      {
+        auto& cpus = numa::find_node(cfg.bind_node)->cpus;
+        return {{cpus.empty() ? numa::current_node().cpus : cpus, begin, end}};
+      }
+      case numa::Placement::INTERLEAVE:
+      {
+        Share s{{}, begin, end};
+        for (auto& n : all)
+          s.cpus.insert(s.cpus.end(), n.cpus.begin(), n.cpus.end());
+        return {s};
+      }
+      case numa::Placement::PARTITION:
+      {
+        // Same proportions as the arena slices in numa::alloc_arena()
+        std::vector<Share> v;
+        uint64_t len = end - begin;
+        uint64_t orphan = begin; // start of slices no share has taken yet
+        for (size_t i = 0; i < all.size(); i++)
+        {
+          uint64_t hi = begin + len * (i + 1) / all.size();
+          if (all[i].cpus.empty())
+          {
+            // Memory-only node: the previous share loads its slice too
+            if (!v.empty())
+            {
+              v.back().hi = hi;
+              orphan = hi;
+            }
+            continue;
+          }
+          if (orphan < hi)
+            v.push_back({all[i].cpus, orphan, hi});
+          orphan = hi;
+        }
+        if (orphan < end)
+          v.push_back({numa::current_node().cpus, orphan, end});
+        return v;
+      }
+    }
+    return {};
+  }
+
+  // Runs fn(lo, hi) over [begin, end) in chunks of `chunk` keys; fn returns
+  // the number of rows it created. Reports the load rate under `what` and
+  // returns the number of rows created.
+  template<typename F>
+  uint64_t parallel_for(
+    const char* what, uint64_t begin, uint64_t end, uint64_t chunk, F&& fn)
+  {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<Share> parts = shares(begin, end);
+    size_t cpus = 0;
+    for (auto& s : parts)
+      cpus += s.cpus.size();
+    size_t budget = Config::instance().threads;
+    if (budget == 0)
+      budget = cpus;
+
+    std::vector<std::atomic<uint64_t>> cursor(parts.size());
+    std::atomic<uint64_t> rows{0};
+    std::vector<std::thread> threads;
+    for (size_t p = 0; p < parts.size(); p++)
+    {
+      Share& s = parts[p];
+      cursor[p].store(s.lo, std::memory_order_relaxed);
+      uint64_t chunks = (s.hi - s.lo + chunk - 1) / chunk;
+      size_t n = std::max<size_t>(1, budget * s.cpus.size() / cpus);
+      n = std::min<size_t>(n, std::min<uint64_t>(chunks, s.cpus.size()));
+      for (size_t t = 0; t < n; t++)
+      {
+        threads.emplace_back([&, p, t]() {
+          pin_thread(parts[p].cpus[t]);
+          uint64_t mine = 0;
+          while (1)
+          {
+            uint64_t lo =
+              cursor[p].fetch_add(chunk, std::memory_order_relaxed);
+            if (lo >= parts[p].hi)
+              break;
+            mine += fn(lo, std::min(lo + chunk, parts[p].hi));
+          }
+          rows.fetch_add(mine, std::memory_order_relaxed);
+        });
+      }
+    }
+    size_t nthreads = threads.size();
+    for (auto& t : threads)
+      t.join();
+
+    double secs = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+    uint64_t total = rows.load(std::memory_order_relaxed);
+    printf(
+      "populate: %s: %lu rows in %.2f s on %zu threads (%.2f Mrows/s)\n",
+      what,
+      total,
+      secs,
+      nthreads,
+      secs > 0 ? total / secs / 1e6 : 0.0);
+    return total;
+  }
+
+  // parallel_for() for tables that create `rows_per_key` rows for every key
+  // in [begin, end); exits if any key was left without its rows, since the
+  // Indexer would later hand out cowns for uninitialised slots
+  template<typename F>
+  void install_all(
+    const char* what,
+    uint64_t begin,
+    uint64_t end,
+    uint64_t chunk,
+    F&& fn,
+    uint64_t rows_per_key = 1)
+  {
+    uint64_t rows = parallel_for(what, begin, end, chunk, std::forward<F>(fn));
+    if (rows != (end - begin) * rows_per_key)
+    {
+      fprintf(
+        stderr,
+        "populate: %s: created %lu rows, expected %lu\n",
+        what,
+        rows,
+        (end - begin) * rows_per_key);
+      exit(1);
+    }
+  }
+}
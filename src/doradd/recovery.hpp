@@ -1,77 +1,170 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <vector>
-#include <unordered_map>
-#include <memory>
-#include "checkpoint_stats.hpp"
+#include "../storage/snapshot_manifest.hpp"
 
+// Streams the newest version of every row in the snapshots of `m` to
+// install(id, data). Snapshots are read newest first, each one split across
+// `threads` threads; a bitmap over [0, capacity) lets the first copy of a row
+// claim it, so install() runs once per row, concurrently for different rows.
+// If install() rejects a row (returns false) an older copy may still claim
+// it. Returns one past the highest row id installed.
+template<typename StorageType, typename Install>
+uint64_t recover_snapshots(StorageType& storage,
+                           const SnapshotManifest& m,
+                           uint64_t capacity,
+                           size_t threads,
+                           std::vector<std::atomic<uint64_t>>& claimed,
+                           Install&& install) {
+    std::atomic<uint64_t> max_seen{0};
+
+    std::vector<std::string> prefixes;
+    for (auto it = m.incrementals.rbegin(); it != m.incrementals.rend(); ++it)
+        prefixes.push_back(snapshot_keys::prefix(snapshot_keys::INCREMENTAL, *it));
+    if (m.base) prefixes.push_back(snapshot_keys::prefix(snapshot_keys::BASE, m.base));
+
+    for (auto& prefix : prefixes) {
+        storage.parallel_for_each_prefix(prefix, threads,
+          [&](std::string_view key, std::string_view data) {
+            uint64_t id = snapshot_keys::row_id(key);
+            if (id >= capacity) {
+                std::cerr << "Row id " << id << " out of range during recovery\n";
+                return;
+            }
+            uint64_t bit = 1ull << (id % 64);
+            if (claimed[id / 64].fetch_or(bit, std::memory_order_relaxed) & bit) return;
+            if (!install(id, data)) {
+                claimed[id / 64].fetch_and(~bit, std::memory_order_relaxed);
+                return;
+            }
+
+            uint64_t seen = max_seen.load(std::memory_order_relaxed);
+            while (seen < id + 1 &&
+                   !max_seen.compare_exchange_weak(seen, id + 1, std::memory_order_relaxed));
+        });
+    }
+    return max_seen.load();
+}
+
+// Where recovery time goes. decode and install are thread time averaged over
+// the recovery threads; scan is the remainder of the wall time (reading and
+// iterating the store, plus idle threads).
+struct RecoveryTimings {
+    double total_ms = 0;
+    double scan_ms = 0;
+    double decode_ms = 0;
+    double install_ms = 0;
+};
+
+// Rebuilds the row store from the last committed checkpoint before the
+// database is populated. Rows are constructed in place in the caller's row
+// arena with make_cown_custom, at the same address a fresh load would use,
+// so recovered rows keep the huge-page layout of the arena. The store is
+// closed again when the Recovery goes out of scope, so the checkpointer can
+// reopen it.
 template<typename StorageType, typename RowType>
 class Recovery {
 public:
-    Recovery(const std::string& path = "/home/syl121/database/checkpoint.db") {
+    Recovery(const std::string& path) {
         if (!storage.open(path)) {
             throw std::runtime_error("Failed to open recovery database");
         }
+        std::string manifest_str;
+        if (storage.get(snapshot_keys::MANIFEST_KEY, manifest_str) &&
+            !SnapshotManifest::parse(manifest_str, manifest)) {
+            throw std::runtime_error("Corrupted snapshot manifest: " + manifest_str);
+        }
     }
 
-    // Recover all rows from the database
-    std::vector<std::pair<uint64_t, RowType>> recover_all() {
-        std::vector<std::pair<uint64_t, RowType>> recovered_data;
-        std::string meta_prefix = "_meta_bit";
-        
-        // First, read all meta bits to determine which version to use
-        std::unordered_map<uint64_t, bool> meta_bits;
-        for (auto& kv : storage.scan_prefix(meta_prefix)) {
-            uint64_t k = std::stoull(kv.first.substr(0, kv.first.size() - meta_prefix.size()));
-            meta_bits[k] = (kv.second.size() > 0 && kv.second[0] == '1');
-        }
+    // Installs every checkpointed row into its slot of the arena `index` is
+    // attached to. Returns the number of rows recovered.
+    template<typename IndexType>
+    size_t recover_into(IndexType* index,
+                        size_t threads = std::thread::hardware_concurrency()) {
+        using clock = std::chrono::steady_clock;
+        auto start = clock::now();
+        const uint64_t capacity = index->capacity();
+        claimed = std::vector<std::atomic<uint64_t>>((capacity + 63) / 64);
+        std::atomic<size_t> installed{0};
+        threads = std::max<size_t>(1, threads);
 
-        // Then read the actual data using the correct version
-        for (const auto& [key, bit] : meta_bits) {
-            std::string versioned_key = std::to_string(key) + "_v" + (bit ? '1' : '0');
-            auto data = storage.get(versioned_key);
-            if (data) {
-                RowType row;
-                std::memcpy(&row, data->data(), sizeof(RowType));
-                recovered_data.emplace_back(key, row);
-            }
-        }
+        // Per-thread time accumulators, picked by thread id hash
+        struct alignas(64) Slot {
+            std::atomic<uint64_t> decode_ns{0};
+            std::atomic<uint64_t> install_ns{0};
+        };
+        std::vector<Slot> slots(64);
 
-        return recovered_data;
-    }
+        recover_snapshots(storage, manifest, capacity, threads, claimed,
+          [&](uint64_t id, std::string_view data) {
+            if (data.size() < sizeof(RowType)) {
+                std::cerr << "Corrupted row data for id=" << id << "\n";
+                return false;
+            }
+            Slot& slot = slots[std::hash<std::thread::id>{}(std::this_thread::get_id()) % slots.size()];
+            auto t0 = clock::now();
+            RowType row;
+            std::memcpy(&row, data.data(), sizeof(RowType));
+            auto t1 = clock::now();
+            index->install(id, row);
+            auto t2 = clock::now();
+            slot.decode_ns.fetch_add((t1 - t0).count(), std::memory_order_relaxed);
+            slot.install_ns.fetch_add((t2 - t1).count(), std::memory_order_relaxed);
+            installed.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        });
 
-    // Recover a specific row by key
-    std::optional<RowType> recover_row(uint64_t key) {
-        // First get the meta bit to determine which version to use
-        std::string meta_key = std::to_string(key) + "_meta_bit";
-        auto meta_data = storage.get(meta_key);
-        if (!meta_data || meta_data->empty()) {
-            return std::nullopt;
+        uint64_t decode_ns = 0, install_ns = 0;
+        for (auto& slot : slots) {
+            decode_ns += slot.decode_ns.load();
+            install_ns += slot.install_ns.load();
         }
+        times.total_ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+        times.decode_ms = decode_ns / 1e6 / threads;
+        times.install_ms = install_ns / 1e6 / threads;
+        times.scan_ms = std::max(0.0, times.total_ms - times.decode_ms - times.install_ms);
 
-        bool bit = (meta_data->at(0) == '1');
-        std::string versioned_key = std::to_string(key) + "_v" + (bit ? '1' : '0');
-        
-        auto data = storage.get(versioned_key);
-        if (!data) {
-            return std::nullopt;
-        }
+        printf("Recovered %zu rows from snapshot %lu on %zu thread(s) in %.1f ms "
+               "(scan %.1f, decode %.1f, install %.1f)\n",
+               installed.load(), manifest.latest(), threads, times.total_ms,
+               times.scan_ms, times.decode_ms, times.install_ms);
+        return installed.load();
+    }
 
-        RowType row;
-        std::memcpy(&row, data->data(), sizeof(RowType));
-        return row;
+    // Whether recover_into() installed row `id`
+    bool recovered(uint64_t id) const {
+        return id / 64 < claimed.size() &&
+               (claimed[id / 64].load(std::memory_order_relaxed) >> (id % 64)) & 1;
     }
 
     // Get the total number of transactions from the database
     uint64_t get_total_transactions() {
-        auto data = storage.get("total_transactions");
-        if (!data) {
+        std::string data;
+        if (!storage.get("total_txns", data)) {
             return 0;
         }
-        return std::stoull(*data);
+        return std::stoull(data);
     }
 
+    const SnapshotManifest& get_manifest() const { return manifest; }
+
+    const RecoveryTimings& timings() const { return times; }
+
 private:
     StorageType storage;
-}; 
\ No newline at end of file
+    SnapshotManifest manifest;
+    std::vector<std::atomic<uint64_t>> claimed;
+    RecoveryTimings times;
+};
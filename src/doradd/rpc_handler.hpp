@@ -1,55 +1,360 @@
 #pragma once
 
 #include "../misc/inter_arrival.hpp"
+#include "arrival_log.hpp"
+#include "config.hpp"
+#include "sweep.hpp"
+#include "tsc.hpp"
+#include "txn_trace.hpp"
+#include "worker_counters.hpp"
 
+#include <algorithm>
 #include <atomic>
 #include <cassert>
+#include <chrono>
 #include <immintrin.h>
+#include <math.h>
+#include <memory>
+#include <queue>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
 
+// Open-loop request generator.
+//
+// RPC_GEN_THREADS generator threads precompute the arrival schedule in
+// blocks of RPC_GEN_BLOCK gaps drawn from the -i distribution, each thread
+// with its own sampler state; block n is built by thread n % RPC_GEN_THREADS
+// into a ring of RPC_GEN_BLOCKS. Sources whose samples depend on the
+// previous ones (trace replay, on/off bursts) run on a single generator
+// thread so the sequence stays intact. run() walks the blocks in order and, each
+// time the clock passes one or more scheduled arrivals, releases all of them
+// to the indexer with one fetch_add, so its per-request work is a compare
+// and a store.
+//
+// Requests are stamped with the time they were scheduled to arrive, not
+// the time they were published: if the generators, the publisher or the
+// pipeline fall behind, the delay still counts towards latency instead of
+// silently lowering the offered load (coordinated omission). How far
+// publishing trails the schedule is reported every second. attach() hands
+// the rate over to a Sweep (see sweep.hpp); between sweep points the
+// handler stops publishing until the workers have drained the backlog and
+// then resumes the schedule from the current time.
+//
+// With -i closed:<clients>:<outstanding>[:<think_ns>] the handler instead
+// runs a closed loop: each of the clients keeps `outstanding` transactions
+// in flight and, when one completes, issues the next after an exponentially
+// distributed think time (mean think_ns, default 0). Completions are read
+// from the per-worker counters that every transaction bumps; clients are
+// interchangeable, so a completion frees the client that has waited
+// longest. Throughput and mean response time (Little's law) are reported
+// every second against the concurrency level.
 struct RPCHandler
 {
   std::atomic<uint64_t>* avail_cnt;
-  struct rand_gen* dist; // inter-arrival distribution
 #ifdef RPC_LATENCY
-  uint64_t log_arr;
+  ArrivalLog* arrivals;
 
   RPCHandler(
-    std::atomic<uint64_t>* avail_cnt_, char* gen_type, uint64_t log_arr_)
-  : avail_cnt(avail_cnt_), log_arr(log_arr_)
+    std::atomic<uint64_t>* avail_cnt_, char* gen_type, ArrivalLog* arrivals_)
+  : avail_cnt(avail_cnt_), arrivals(arrivals_)
 #else
   RPCHandler(std::atomic<uint64_t>* avail_cnt_, char* gen_type)
   : avail_cnt(avail_cnt_)
 #endif
   {
-    dist = lancet_init_rand(gen_type);
+    if (tsc::cycles_per_ns_fp == 0)
+      tsc::calibrate();
+    if (strncmp(gen_type, "closed", 6) == 0)
+    {
+      closed = true;
+      int n = sscanf(
+        gen_type, "closed:%zu:%zu:%lu", &clients, &outstanding, &think_ns);
+      if (n < 2 || clients == 0 || outstanding == 0)
+      {
+        fprintf(
+          stderr,
+          "Usage: -i closed:<clients>:<outstanding>[:<think_ns>]\n");
+        exit(1);
+      }
+      return;
+    }
+
+    // lancet_init_rand() tokenises its argument in place, so every
+    // generator after the first parses a copy
+    std::string spec(gen_type);
+    for (size_t t = 0; t < gen_threads; t++)
+    {
+      dists[t] = lancet_init_rand(t == 0 ? gen_type : strdup(spec.c_str()));
+      if (!dists[t])
+        exit(1);
+      if (dists[t]->gen_type == GEN_TRACE || dists[t]->gen_type == GEN_ONOFF)
+        gen_threads = 1;
+    }
+  }
+
+  // Steps the open-loop rate through `s` instead of running the -i
+  // distribution as given
+  void attach(Sweep* s)
+  {
+    if (closed)
+    {
+      fprintf(stderr, "--sweep needs an open-loop -i distribution\n");
+      exit(1);
+    }
+    sweep = s;
   }
 
   void run()
   {
-    long next_ts = time_ns();
-    int i = 0;
+    if (closed)
+      run_closed();
+    else
+      run_open();
+  }
+
+  void run_open()
+  {
+    for (size_t t = 0; t < gen_threads; t++)
+      generators.emplace_back([this, t]() { generate(t); });
+
+    auto& workers = WorkerCounters::instance();
+    uint64_t executed_base = workers.executed();
+    uint64_t i = 0; // requests published
+    uint64_t base = 0; // scheduled start of the current block
+    uint64_t max_lag = 0;
+    uint64_t last_report = 0;
+    uint64_t reported = 0;
+    // Under a sweep, gaps are scaled by the target over the sample mean
+    uint64_t scale = 1ull << 32; // 32.32 fixed point
+    uint64_t sampled_ns = 0;
+    uint64_t sampled = 0;
+    auto scaled = [&scale](uint64_t cycles) {
+      return static_cast<uint64_t>(
+        (static_cast<unsigned __int128>(cycles) * scale) >> 32);
+    };
+
+    for (uint64_t n = 0;; n++)
+    {
+      Block& b = blocks[n % RPC_GEN_BLOCKS];
+      while (b.ready.load(std::memory_order_acquire) != n + 1)
+        _mm_pause();
+      if (n == 0)
+        base = last_report = rdtsc();
+      if (sweep)
+      {
+        sampled_ns += b.span_ns;
+        sampled += RPC_GEN_BLOCK;
+        scale = static_cast<uint64_t>(
+          sweep->target_gap_ns() * sampled / std::max(sampled_ns, 1ul) *
+          (1ull << 32));
+      }
+
+      size_t k = 0;
+      while (k < RPC_GEN_BLOCK)
+      {
+        if (sweep && sweep->draining())
+        {
+          while (workers.executed() - executed_base < i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+          uint64_t now = rdtsc();
+          sweep->drained(now);
+          base = now - scaled(b.at[k]);
+          max_lag = 0;
+        }
+
+        uint64_t now = rdtsc();
+        size_t first = k;
+        Admit a = Admit::OK;
+        for (; k < RPC_GEN_BLOCK && base + scaled(b.at[k]) <= now; k++, i++)
+        {
+          if ((a = admit(i, base + scaled(b.at[k]))) != Admit::OK)
+            break;
+        }
+        if (a != Admit::OK)
+        {
+          avail_cnt->fetch_add(k - first, std::memory_order_relaxed);
+          // A full arrival log ends the sweep point, which then drains
+          if (a == Admit::LOG_FULL && sweep && sweep->overflow(now, i))
+            continue;
+          if (sweep)
+            sweep->stop();
+          return;
+        }
+        if (k == first)
+        {
+          _mm_pause();
+          continue;
+        }
+        avail_cnt->fetch_add(k - first, std::memory_order_relaxed);
+        uint64_t lag = now - (base + scaled(b.at[first]));
+        max_lag = std::max(max_lag, lag);
+        if (sweep && !sweep->tick(now, i, lag))
+          return;
+
+        if (tsc::to_ns(now - last_report) >= 1'000'000'000)
+        {
+          printf(
+            "rpc_handler: %.2f Mreq/s, max lag %.1f us\n",
+            (i - reported) * 1e3 / tsc::to_ns(now - last_report),
+            tsc::to_ns(max_lag) / 1e3);
+          last_report = now;
+          reported = i;
+          max_lag = 0;
+        }
+      }
+
+      base += scaled(tsc::to_cycles(b.span_ns));
+      consumed.store(n + 1, std::memory_order_release);
+    }
+  }
+
+  void run_closed()
+  {
+    auto& workers = WorkerCounters::instance();
+    size_t window = clients * outstanding;
+    double think_cycles = static_cast<double>(tsc::to_cycles(think_ns));
+    unsigned short xsubi[3] = {0x330e, 0xabcd, 0x1234};
+
+    // Issue times of idle client slots, earliest first
+    std::priority_queue<uint64_t, std::vector<uint64_t>, std::greater<>> idle;
+    uint64_t start = rdtsc();
+    for (size_t c = 0; c < window; c++)
+      idle.push(start);
+
+    uint64_t i = 0; // requests issued
+    uint64_t completed = 0;
+    uint64_t base = workers.executed();
+    uint64_t last_report = start;
+    uint64_t reported = 0;
 
-    // spinning and populating cnts
     while (1)
     {
-      while (time_ns() < next_ts)
+      uint64_t now = rdtsc();
+      uint64_t done = workers.executed() - base;
+      for (; completed < done; completed++)
+      {
+        double think = think_ns ? -log(1.0 - erand48(xsubi)) * think_cycles : 0;
+        idle.push(now + static_cast<uint64_t>(think));
+      }
+
+      size_t n = 0;
+      for (; !idle.empty() && idle.top() <= now; n++, i++)
+      {
+        if (admit(i, idle.top()) != Admit::OK)
+        {
+          avail_cnt->fetch_add(n, std::memory_order_relaxed);
+          return;
+        }
+        idle.pop();
+      }
+      if (n)
+        avail_cnt->fetch_add(n, std::memory_order_relaxed);
+      else
         _mm_pause();
 
-#ifdef RPC_LATENCY
-      if (i >= RPC_LOG_SIZE)
+      if (tsc::to_ns(now - last_report) >= 1'000'000'000)
       {
-        printf("entire reqs are %d\n", i);
-        break;
+        double secs = tsc::to_ns(now - last_report) / 1e9;
+        double tput = (completed - reported) / secs;
+        printf(
+          "rpc_handler: closed %zux%zu (%zu outstanding, think %lu ns): "
+          "%.2f Mtx/s, mean response %.1f us\n",
+          clients,
+          outstanding,
+          window,
+          think_ns,
+          tput / 1e6,
+          tput > 0 ? (window / tput - think_ns / 1e9) * 1e6 : 0.0);
+        last_report = now;
+        reported = completed;
       }
-      auto* addr =
-        reinterpret_cast<void*>(log_arr + (uint64_t)(i++ * sizeof(ts_type)));
-      *reinterpret_cast<ts_type*>(addr) = std::chrono::system_clock::now();
+    }
+  }
+
+  // Stops the generator threads once run() has returned or been cancelled
+  void stop()
+  {
+    stop_flag.store(true, std::memory_order_relaxed);
+    for (auto& t : generators)
+      t.join();
+    generators.clear();
+  }
+
+private:
+  struct alignas(64) Block
+  {
+    std::atomic<uint64_t> ready{0}; // 1 + number of the block it holds
+    uint64_t span_ns; // sum of the block's gaps
+    uint64_t at[RPC_GEN_BLOCK]; // arrivals, in cycles from the block start
+  };
+
+  bool closed = false;
+  size_t clients = 0;
+  size_t outstanding = 0;
+  uint64_t think_ns = 0;
+  Sweep* sweep = nullptr;
+
+  struct rand_gen* dists[RPC_GEN_THREADS]; // inter-arrival distributions
+  size_t gen_threads = RPC_GEN_THREADS;
+  std::unique_ptr<Block[]> blocks{new Block[RPC_GEN_BLOCKS]};
+  alignas(64) std::atomic<uint64_t> consumed{0};
+  std::atomic<bool> stop_flag{false};
+  std::vector<std::thread> generators;
+
+  enum class Admit
+  {
+    OK,
+    LOG_FULL, // too many requests in flight for the arrival log
+    LOG_END // the run has published RPC_LOG_SIZE requests
+  };
+
+  // Stamps request `i`, scheduled at `at`
+  Admit admit(uint64_t i, uint64_t at)
+  {
+#ifdef RPC_LATENCY
+    if (i >= RPC_LOG_SIZE)
+    {
+      printf("entire reqs are %lu\n", i);
+      return Admit::LOG_END;
+    }
+    if (!arrivals->record(i, at))
+    {
+      printf("arrival log full: %lu reqs in flight\n", i);
+      return Admit::LOG_FULL;
+    }
 #endif
+    txn_trace::point(txn_trace::ARRIVAL, i, "rpc_handler", at);
+    return Admit::OK;
+  }
 
-      avail_cnt->fetch_add(1, std::memory_order_relaxed);
-      next_ts += gen_inter_arrival(dist);
+  void generate(size_t t)
+  {
+    // Thread 0 draws the same sequence drand48() would
+    unsigned short xsubi[3] = {
+      0x330e, 0xabcd, static_cast<unsigned short>(0x1234 + t)};
+
+    for (uint64_t n = t;; n += gen_threads)
+    {
+      while (n >= consumed.load(std::memory_order_acquire) + RPC_GEN_BLOCKS)
+      {
+        if (stop_flag.load(std::memory_order_relaxed))
+          return;
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+      }
+
+      Block& b = blocks[n % RPC_GEN_BLOCKS];
+      uint64_t ns = 0;
+      for (size_t k = 0; k < RPC_GEN_BLOCK; k++)
+      {
+        b.at[k] = tsc::to_cycles(ns);
+        ns += std::max(0L, lround(generate_r(dists[t], xsubi)));
+      }
+      b.span_ns = ns;
+      b.ready.store(n + 1, std::memory_order_release);
     }
   }
 };
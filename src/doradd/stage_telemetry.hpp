@@ -0,0 +1,216 @@
+#pragma once
+
+#include "tsc.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <thread>
+#include <unistd.h>
+
+// Per-stage pipeline telemetry, compiled in with STAGE_TELEMETRY.
+//
+// Every pipeline stage owns a StageTelemetry and splits its time, in TSC
+// cycles, between busy (doing work), empty (spinning on an empty input),
+// full (blocked pushing into a full output ring) and checkpoint handling.
+// account() charges the cycles since the previous call to one bucket, so a
+// stage loop pays one rdtsc and one add per transition. Stages also count
+// batches, transactions, a log2 batch-size histogram and the occupancy of
+// the ring they share with the next stage (the spawner samples its input).
+//
+// A sampler thread copies all counters into a shared-memory page
+// (/dev/shm/doradd-telemetry) every SAMPLE_INTERVAL; telemetry_cli reads it
+// while the benchmark runs.
+namespace telemetry
+{
+  enum Bucket
+  {
+    BUSY,
+    EMPTY_SPIN,
+    FULL_SPIN,
+    CHECKPOINT,
+    NUM_BUCKETS
+  };
+
+  static constexpr size_t MAX_STAGES = 8;
+  static constexpr size_t BATCH_HIST = 8; // batch sizes 1, 2-3, 4-7, ...
+  static constexpr uint32_t PAGE_MAGIC = 0x54454c45; // "TELE"
+  static constexpr const char* PAGE_PATH = "/dev/shm/doradd-telemetry";
+  static constexpr auto SAMPLE_INTERVAL = std::chrono::milliseconds(100);
+
+  // Plain snapshot of one stage, as published in the shared page
+  struct StageSnapshot
+  {
+    char name[16];
+    uint64_t cycles[NUM_BUCKETS];
+    uint64_t batches;
+    uint64_t txns;
+    uint64_t batch_hist[BATCH_HIST];
+    uint64_t occupancy_sum;
+    uint64_t occupancy_samples;
+  };
+
+  // Shared page layout. `seq` is odd while the sampler is writing.
+  struct Page
+  {
+    uint32_t magic;
+    uint32_t num_stages;
+    std::atomic<uint64_t> seq;
+    uint64_t tsc;
+    uint64_t wall_ns;
+    StageSnapshot stages[MAX_STAGES];
+  };
+
+  // Live counters of one stage; single writer, read by the sampler
+  struct alignas(64) StageCounters
+  {
+    char name[16] = {};
+    std::atomic<uint64_t> cycles[NUM_BUCKETS] = {};
+    std::atomic<uint64_t> batches{0};
+    std::atomic<uint64_t> txns{0};
+    std::atomic<uint64_t> batch_hist[BATCH_HIST] = {};
+    std::atomic<uint64_t> occupancy_sum{0};
+    std::atomic<uint64_t> occupancy_samples{0};
+  };
+
+  inline void bump(std::atomic<uint64_t>& c, uint64_t v)
+  {
+    c.store(c.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+  }
+
+  class Registry
+  {
+  public:
+    static Registry& instance()
+    {
+      static Registry r;
+      return r;
+    }
+
+    StageCounters* add(const char* name)
+    {
+      size_t i = count.fetch_add(1, std::memory_order_relaxed);
+      if (i >= MAX_STAGES)
+        return nullptr;
+      strncpy(stages[i].name, name, sizeof(stages[i].name) - 1);
+      return &stages[i];
+    }
+
+    // Maps the shared page and starts publishing snapshots
+    void start_sampler()
+    {
+      int fd = open(PAGE_PATH, O_RDWR | O_CREAT | O_TRUNC, 0644);
+      if (fd < 0 || ftruncate(fd, sizeof(Page)) != 0)
+      {
+        fprintf(stderr, "telemetry: cannot create %s\n", PAGE_PATH);
+        if (fd >= 0)
+          close(fd);
+        return;
+      }
+      void* p =
+        mmap(nullptr, sizeof(Page), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      close(fd);
+      if (p == MAP_FAILED)
+        return;
+      page = static_cast<Page*>(p);
+      page->magic = PAGE_MAGIC;
+
+      sampler = std::thread([this]() {
+        while (!stop.load(std::memory_order_relaxed))
+        {
+          publish();
+          std::this_thread::sleep_for(SAMPLE_INTERVAL);
+        }
+        publish();
+      });
+    }
+
+    void stop_sampler()
+    {
+      stop.store(true, std::memory_order_relaxed);
+      if (sampler.joinable())
+        sampler.join();
+    }
+
+  private:
+    StageCounters stages[MAX_STAGES];
+    std::atomic<size_t> count{0};
+    Page* page = nullptr;
+    std::thread sampler;
+    std::atomic<bool> stop{false};
+
+    void publish()
+    {
+      size_t n = std::min(count.load(std::memory_order_relaxed), MAX_STAGES);
+      page->seq.fetch_add(1, std::memory_order_acq_rel);
+      page->num_stages = static_cast<uint32_t>(n);
+      page->tsc = rdtsc();
+      page->wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch())
+                        .count();
+      for (size_t i = 0; i < n; i++)
+      {
+        auto& s = stages[i];
+        auto& d = page->stages[i];
+        memcpy(d.name, s.name, sizeof(d.name));
+        for (int b = 0; b < NUM_BUCKETS; b++)
+          d.cycles[b] = s.cycles[b].load(std::memory_order_relaxed);
+        d.batches = s.batches.load(std::memory_order_relaxed);
+        d.txns = s.txns.load(std::memory_order_relaxed);
+        for (size_t b = 0; b < BATCH_HIST; b++)
+          d.batch_hist[b] = s.batch_hist[b].load(std::memory_order_relaxed);
+        d.occupancy_sum = s.occupancy_sum.load(std::memory_order_relaxed);
+        d.occupancy_samples =
+          s.occupancy_samples.load(std::memory_order_relaxed);
+      }
+      page->seq.fetch_add(1, std::memory_order_acq_rel);
+    }
+  };
+}
+
+// Handle used by a stage loop. Without STAGE_TELEMETRY every method is an
+// empty inline function.
+class StageTelemetry
+{
+#ifdef STAGE_TELEMETRY
+  telemetry::StageCounters* c;
+  uint64_t last;
+
+public:
+  explicit StageTelemetry(const char* name)
+  : c(telemetry::Registry::instance().add(name)), last(rdtsc())
+  {}
+
+  // Charges the cycles since the previous call to `b`
+  void account(telemetry::Bucket b)
+  {
+    uint64_t now = rdtsc();
+    if (c)
+      telemetry::bump(c->cycles[b], now - last);
+    last = now;
+  }
+
+  void batch(size_t txns, size_t ring_occupancy)
+  {
+    if (!c)
+      return;
+    telemetry::bump(c->batches, 1);
+    telemetry::bump(c->txns, txns);
+    size_t bucket = txns ? 63 - __builtin_clzll(txns) : 0;
+    telemetry::bump(
+      c->batch_hist[std::min(bucket, telemetry::BATCH_HIST - 1)], 1);
+    telemetry::bump(c->occupancy_sum, ring_occupancy);
+    telemetry::bump(c->occupancy_samples, 1);
+  }
+#else
+public:
+  explicit StageTelemetry(const char*) {}
+  void account(telemetry::Bucket) {}
+  void batch(size_t, size_t) {}
+#endif
+};
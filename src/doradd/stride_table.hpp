@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cassert>
+#include <cpp/when.h>
+#include <new>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace verona::rt;
+using namespace verona::cpp;
+
+static constexpr size_t CACHE_LINE = 64;
+
+// Whole cache lines of padding after every row (-DROW_PAD_LINES=<n>), so
+// rows updated by different workers never share the line pair the
+// adjacent-line prefetcher fetches together
+#ifndef ROW_PAD_LINES
+#  define ROW_PAD_LINES 0
+#endif
+
+// Bytes from one row slot to the next: the cown header plus the row,
+// rounded up to cache lines, plus ROW_PAD_LINES
+template<typename T>
+constexpr size_t row_stride()
+{
+  size_t lines = (sizeof(ActualCown<T>) + CACHE_LINE - 1) / CACHE_LINE;
+  return (lines + ROW_PAD_LINES) * CACHE_LINE;
+}
+
+// Drops `c` without releasing its reference, so the cown is never
+// collected. Table rows live as long as the process and are reached
+// through get_cown_ptr_from_addr(), so this reference is what keeps them
+// alive. The cown_ptr is moved into a buffer whose destructor never runs.
+template<typename T>
+void leak_cown(cown_ptr<T>&& c)
+{
+  alignas(cown_ptr<T>) unsigned char sink[sizeof(cown_ptr<T>)];
+  new (sink) cown_ptr<T>(std::move(c));
+}
+
+// Table whose rows sit at arena + STRIDE * key.
+//
+// Nothing maps keys to cowns: the Indexer turns a key into a cown address
+// with one multiply-add instead of loading it from a pointer array (one
+// cache miss per key, and 8 bytes per row). attach() hands the table its
+// arena, install() constructs a row in its slot and get_row() rebuilds a
+// cown_ptr from the slot address.
+//
+// install() leaks the reference make_cown_custom() returns (leak_cown()),
+// so a row outlives every cown_ptr later made from its address; the arena
+// is never unmapped.
+template<typename T, size_t STRIDE = row_stride<T>()>
+class StrideTable
+{
+  static_assert(STRIDE >= sizeof(ActualCown<T>), "row does not fit its slot");
+  static_assert(STRIDE % alignof(ActualCown<T>) == 0, "misaligned row slot");
+
+public:
+  static constexpr size_t stride()
+  {
+    return STRIDE;
+  }
+
+  void attach(void* arena_)
+  {
+    arena = static_cast<uint8_t*>(arena_);
+  }
+
+  void* arena_addr() const
+  {
+    return arena;
+  }
+
+  uint64_t get_base_addr(uint64_t key) const
+  {
+    return reinterpret_cast<uint64_t>(arena + STRIDE * key);
+  }
+
+  cown_ptr<T> get_row(uint64_t key) const
+  {
+    return get_cown_ptr_from_addr<T>(arena + STRIDE * key);
+  }
+
+  // Constructs row `key` in place from `args`
+  template<typename... Args>
+  void install(uint64_t key, Args&&... args)
+  {
+    void* slot = arena + STRIDE * key;
+    cown_ptr<T> c = make_cown_custom<T>(slot, std::forward<Args>(args)...);
+    assert(c.get_base_addr() == get_base_addr(key));
+    leak_cown(std::move(c));
+  }
+
+private:
+  uint8_t* arena = nullptr;
+};
@@ -0,0 +1,325 @@
+#pragma once
+
+#include "latency_histogram.hpp"
+#include "tsc.hpp"
+#include "worker_counters.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Throughput/latency curve in one process.
+//
+//   --sweep <Mreq/s>[,<Mreq/s>...] [--warmup <s>] [--measure <s>]
+//
+// The RPC handler visits the rates in ascending order, scaling the -i
+// distribution to each one without changing its shape. Every point warms up
+// for --warmup seconds (default 2) and is then measured for --measure
+// seconds (default 5). A point is saturated when the generator offers, or
+// the workers complete, less than SATURATION_RATIO of the rate, or (under
+// LOG_LATENCY) when p99 exceeds P99_KNEE_FACTOR times the first point's. After the first
+// saturated rate the sweep bisects between it and the last sustained rate
+// REFINE_STEPS times; the highest sustained rate is reported as the knee.
+//
+// Between points the sweep drains: the RPC handler stops publishing until
+// the workers have executed everything published so far, so no point
+// starts on top of the backlog of a saturated one. A point whose backlog
+// fills the RPC_LATENCY arrival log is cut short and counted as saturated.
+//
+// Each point is one JSON object per line, printed and written to
+// results/<gen_type>-sweep.json.
+class Sweep
+{
+public:
+  static constexpr double SATURATION_RATIO = 0.95;
+  static constexpr double P99_KNEE_FACTOR = 10;
+  static constexpr int REFINE_STEPS = 3;
+
+  Sweep(int argc, char** argv)
+  {
+    for (int i = 1; i < argc; i++)
+    {
+      if (strcmp(argv[i], "--sweep") == 0 && i + 1 < argc)
+      {
+        char* tok = strtok(argv[++i], ",");
+        for (; tok; tok = strtok(nullptr, ","))
+          rates.push_back(atof(tok));
+      }
+      else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+        warmup_s = atof(argv[++i]);
+      else if (strcmp(argv[i], "--measure") == 0 && i + 1 < argc)
+        measure_s = atof(argv[++i]);
+    }
+    rates.erase(
+      std::remove_if(
+        rates.begin(), rates.end(), [](double r) { return !(r > 0); }),
+      rates.end());
+    std::sort(rates.begin(), rates.end());
+    if (!rates.empty())
+      rate = rates.front();
+  }
+
+  bool enabled() const
+  {
+    return !rates.empty();
+  }
+
+  void open(const std::string& path)
+  {
+    out = fopen(path.c_str(), "w");
+    if (!out)
+      fprintf(stderr, "sweep: cannot open %s\n", path.c_str());
+  }
+
+  // Mean inter-arrival time the RPC handler should currently offer
+  double target_gap_ns() const
+  {
+    return 1e3 / rate;
+  }
+
+  // Called by the RPC handler after each batch it publishes, with the
+  // number of requests published so far and how late the batch was.
+  // Returns false once the sweep is over.
+  bool tick(uint64_t now, uint64_t published, uint64_t lag)
+  {
+    max_lag = std::max(max_lag, lag);
+    if (now < phase_end)
+      return true;
+    return advance(now, published);
+  }
+
+  // True between points, while the RPC handler waits for the workers to
+  // catch up; drained() then starts the next point
+  bool draining() const
+  {
+    return phase == DRAIN;
+  }
+
+  void drained(uint64_t now)
+  {
+    phase = WARMUP;
+    phase_end = after(now, warmup_s);
+  }
+
+  // Called by the RPC handler when the backlog of the current point has
+  // filled the arrival log. Returns false once the sweep is over.
+  bool overflow(uint64_t now, uint64_t published)
+  {
+    if (phase == MEASURE)
+      measure(now, published, true);
+    else
+    {
+      char line[128];
+      snprintf(
+        line,
+        sizeof(line),
+        "{\"point\": %d, \"rate_mreqs\": %.4f, \"overflow\": true, "
+        "\"saturated\": true}",
+        point++,
+        rate);
+      emit(line);
+    }
+    if (saturated == 0 || rate < saturated)
+      saturated = rate;
+    return next_point(now);
+  }
+
+  // Ends the sweep early, when the run stops publishing before the knee
+  // is bracketed
+  void stop()
+  {
+    if (!done.load(std::memory_order_relaxed))
+      finish();
+  }
+
+  // Blocks until the sweep is over
+  void wait() const
+  {
+    while (!done.load(std::memory_order_acquire))
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+
+private:
+  enum Phase
+  {
+    START,
+    WARMUP,
+    MEASURE,
+    DRAIN
+  };
+
+  std::vector<double> rates; // Mreq/s, ascending
+  double warmup_s = 2;
+  double measure_s = 5;
+  FILE* out = nullptr;
+
+  Phase phase = START;
+  size_t next_rate = 0;
+  double rate = 0;
+  int point = 0;
+  uint64_t phase_end = 0;
+  std::atomic<bool> done{false};
+
+  // Bracket around the knee: highest sustained and lowest saturated rate
+  double sustained = 0;
+  double saturated = 0;
+  int refine = 0;
+  double base_p99_ns = 0;
+
+  // Snapshot at the start of the measurement
+  uint64_t start_tsc = 0;
+  uint64_t start_published = 0;
+  uint64_t start_executed = 0;
+  uint64_t max_lag = 0;
+#if defined(LOG_LATENCY) && !defined(LOG_SCHED_OHEAD)
+  std::unique_ptr<LatencyHistograms::Counts> start_counts =
+    std::make_unique<LatencyHistograms::Counts>();
+  std::unique_ptr<LatencyHistograms::Counts> end_counts =
+    std::make_unique<LatencyHistograms::Counts>();
+#endif
+
+  uint64_t after(uint64_t now, double secs)
+  {
+    return now + tsc::to_cycles(static_cast<uint64_t>(secs * 1e9));
+  }
+
+  bool advance(uint64_t now, uint64_t published)
+  {
+    switch (phase)
+    {
+      case START:
+        return next_point(now);
+      case WARMUP:
+        phase = MEASURE;
+        phase_end = after(now, measure_s);
+        start_tsc = now;
+        start_published = published;
+        start_executed = WorkerCounters::instance().executed();
+        max_lag = 0;
+#if defined(LOG_LATENCY) && !defined(LOG_SCHED_OHEAD)
+        LatencyHistograms::instance().merge(*start_counts);
+#endif
+        return true;
+      case MEASURE:
+        if (measure(now, published, false))
+          sustained = std::max(sustained, rate);
+        else if (saturated == 0 || rate < saturated)
+          saturated = rate;
+        return next_point(now);
+      case DRAIN:
+        return true;
+    }
+    return false;
+  }
+
+  // Records the point just measured; true if the rate was sustained
+  bool measure(uint64_t now, uint64_t published, bool overflowed)
+  {
+    double secs = tsc::to_ns(now - start_tsc) / 1e9;
+    double offered = (published - start_published) / secs / 1e6;
+    double executed =
+      (WorkerCounters::instance().executed() - start_executed) / secs / 1e6;
+    double lag_us = tsc::to_ns(max_lag) / 1e3;
+    bool ok = !overflowed && executed >= SATURATION_RATIO * offered &&
+      offered >= SATURATION_RATIO * rate;
+
+    char latency[128] = "";
+#if defined(LOG_LATENCY) && !defined(LOG_SCHED_OHEAD)
+    LatencyHistograms::instance().merge(*end_counts);
+    uint64_t total = 0;
+    for (size_t b = 0; b < end_counts->size(); b++)
+    {
+      (*end_counts)[b] -= (*start_counts)[b];
+      total += (*end_counts)[b];
+    }
+    if (total)
+    {
+      double p50 = LatencyHistograms::percentile(*end_counts, total, 0.50);
+      double p99 = LatencyHistograms::percentile(*end_counts, total, 0.99);
+      double p999 = LatencyHistograms::percentile(*end_counts, total, 0.999);
+      if (base_p99_ns == 0)
+        base_p99_ns = p99;
+      else if (p99 > P99_KNEE_FACTOR * base_p99_ns)
+        ok = false;
+      snprintf(
+        latency,
+        sizeof(latency),
+        ", \"p50_us\": %.1f, \"p99_us\": %.1f, \"p999_us\": %.1f",
+        p50 / 1e3,
+        p99 / 1e3,
+        p999 / 1e3);
+    }
+#endif
+
+    char line[512];
+    snprintf(
+      line,
+      sizeof(line),
+      "{\"point\": %d, \"rate_mreqs\": %.4f, \"offered_mreqs\": %.4f, "
+      "\"executed_mtxs\": %.4f, \"max_lag_us\": %.1f%s, \"overflow\": %s, "
+      "\"saturated\": %s}",
+      point++,
+      rate,
+      offered,
+      executed,
+      lag_us,
+      latency,
+      overflowed ? "true" : "false",
+      ok ? "false" : "true");
+    emit(line);
+    return ok;
+  }
+
+  // Picks the next rate; false when the knee is bracketed closely enough
+  bool next_point(uint64_t now)
+  {
+    if (saturated == 0 && next_rate < rates.size())
+      rate = rates[next_rate++];
+    else if (saturated != 0 && refine++ < REFINE_STEPS)
+      rate = (sustained + saturated) / 2;
+    else
+      return finish();
+
+    // The first point has no backlog to drain
+    if (point == 0)
+      drained(now);
+    else
+      phase = DRAIN;
+    return true;
+  }
+
+  bool finish()
+  {
+    char line[128];
+    snprintf(
+      line,
+      sizeof(line),
+      "{\"knee_mreqs\": %.4f, \"saturated_mreqs\": %.4f}",
+      sustained,
+      saturated);
+    emit(line);
+    if (out)
+      fclose(out);
+    out = nullptr;
+    done.store(true, std::memory_order_release);
+    return false;
+  }
+
+  void emit(const char* line)
+  {
+    printf("sweep: %s\n", line);
+    if (out)
+    {
+      fprintf(out, "%s\n", line);
+      fflush(out);
+    }
+  }
+};
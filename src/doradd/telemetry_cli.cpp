@@ -0,0 +1,116 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <thread>
+#include <unistd.h>
+
+#include "stage_telemetry.hpp"
+
+using namespace telemetry;
+
+// Copies the shared page, retrying while the sampler is mid-update
+static void read_page(const Page* page, Page& out) {
+    while (true) {
+        uint64_t before = page->seq.load(std::memory_order_acquire);
+        if (before & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+        out.magic = page->magic;
+        out.num_stages = page->num_stages;
+        out.tsc = page->tsc;
+        out.wall_ns = page->wall_ns;
+        memcpy(out.stages, page->stages, sizeof(out.stages));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (page->seq.load(std::memory_order_relaxed) == before)
+            return;
+    }
+}
+
+static void print_delta(const Page& a, const Page& b) {
+    double secs = (b.wall_ns - a.wall_ns) / 1e9;
+    if (secs <= 0) {
+        printf("(no new sample)\n");
+        return;
+    }
+    printf("%-12s %6s %6s %6s %6s %12s %12s %8s %8s  batch size histogram (1,2-3,4-7,...)\n",
+           "stage", "busy%", "empty%", "full%", "ckpt%", "batches/s", "txns/s",
+           "avg_bsz", "avg_occ");
+    for (uint32_t i = 0; i < b.num_stages && i < MAX_STAGES; i++) {
+        const auto& s0 = a.stages[i];
+        const auto& s1 = b.stages[i];
+        uint64_t cycles[NUM_BUCKETS];
+        uint64_t total = 0;
+        for (int k = 0; k < NUM_BUCKETS; k++) {
+            cycles[k] = i < a.num_stages ? s1.cycles[k] - s0.cycles[k] : s1.cycles[k];
+            total += cycles[k];
+        }
+        auto pct = [&](int k) { return total ? 100.0 * cycles[k] / total : 0.0; };
+        uint64_t batches = s1.batches - (i < a.num_stages ? s0.batches : 0);
+        uint64_t txns = s1.txns - (i < a.num_stages ? s0.txns : 0);
+        uint64_t occ_sum = s1.occupancy_sum - (i < a.num_stages ? s0.occupancy_sum : 0);
+        uint64_t occ_n =
+            s1.occupancy_samples - (i < a.num_stages ? s0.occupancy_samples : 0);
+
+        printf("%-12s %6.1f %6.1f %6.1f %6.1f %12.0f %12.0f %8.1f %8.1f ",
+               s1.name, pct(BUSY), pct(EMPTY_SPIN), pct(FULL_SPIN), pct(CHECKPOINT),
+               batches / secs, txns / secs,
+               batches ? static_cast<double>(txns) / batches : 0.0,
+               occ_n ? static_cast<double>(occ_sum) / occ_n : 0.0);
+        for (size_t h = 0; h < BATCH_HIST; h++)
+            printf(" %lu", s1.batch_hist[h] - (i < a.num_stages ? s0.batch_hist[h] : 0));
+        printf("\n");
+    }
+    printf("\n");
+}
+
+// Attaches to the telemetry page of a running benchmark built with
+// STAGE_TELEMETRY and prints, every interval, where each pipeline stage
+// spends its cycles and how full its rings are.
+int main(int argc, char** argv) {
+    long interval_ms = 1000;
+    long count = -1;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-i" && i + 1 < argc) {
+            interval_ms = std::atol(argv[++i]);
+        } else if (arg == "-n" && i + 1 < argc) {
+            count = std::atol(argv[++i]);
+        } else {
+            fprintf(stderr, "Usage: %s [-i interval_ms] [-n samples]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    int fd = open(PAGE_PATH, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Cannot open %s; is a STAGE_TELEMETRY build running?\n", PAGE_PATH);
+        return 1;
+    }
+    void* p = mmap(nullptr, sizeof(Page), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        perror("mmap");
+        return 1;
+    }
+    const Page* page = static_cast<const Page*>(p);
+    if (page->magic != PAGE_MAGIC) {
+        fprintf(stderr, "%s is not a telemetry page\n", PAGE_PATH);
+        return 1;
+    }
+
+    // Page holds an atomic, so alternate between two copies instead of
+    // assigning one to the other
+    Page samples[2];
+    read_page(page, samples[0]);
+    for (long n = 0; count < 0 || n < count; n++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(interval_ms));
+        read_page(page, samples[(n + 1) & 1]);
+        print_delta(samples[n & 1], samples[(n + 1) & 1]);
+    }
+    munmap(p, sizeof(Page));
+    return 0;
+}
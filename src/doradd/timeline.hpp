@@ -0,0 +1,238 @@
+#pragma once
+
+#include "tsc.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+// Run-wide event timeline on a single TSC time base.
+//
+// Checkpoint phases (marker, key collection, behaviour dispatch, row
+// writes, manifest commit, flush, fold, GC) are recorded as [start, end]
+// intervals by whichever thread runs them, and a sampler thread adds
+// throughput and latency samples every SAMPLE_INTERVAL. Recording claims a
+// slot in a preallocated array with one fetch_add and publishes it by
+// storing its kind last, so no thread ever blocks on the timeline; once the
+// array is full further events are dropped and counted.
+//
+// export_csv() writes everything, ordered by start time, to one CSV that
+// parse_timeline.py lines up to show what each phase costs in throughput
+// and tail latency.
+namespace timeline
+{
+  enum Kind : uint32_t
+  {
+    NONE,
+    CKPT_MARKER, // v0: transactions since the previous marker
+    CKPT_COLLECT, // v0: dirty rows
+    CKPT_DISPATCH, // v0: write behaviours dispatched
+    CKPT_WRITE, // row writes, from dispatch to the last batch
+    CKPT_COMMIT, // manifest, global snapshot and total_txns batch
+    CKPT_FLUSH,
+    CKPT_DONE, // marker to durable; v0: rows, v1: ns since previous done
+    FOLD, // v0: rows in the new base
+    GC, // v0: snapshots reclaimed
+    THROUGHPUT, // v0: spawned tx/s, v1: executed tx/s
+    LATENCY, // v0/v1/v2: p50/p99/p999 in ns
+    NUM_KINDS
+  };
+
+  static constexpr const char* KIND_NAMES[NUM_KINDS] = {
+    "none",
+    "marker",
+    "collect",
+    "dispatch",
+    "write",
+    "commit",
+    "flush",
+    "done",
+    "fold",
+    "gc",
+    "throughput",
+    "latency"};
+
+  static constexpr size_t CAPACITY = 1 << 18;
+  static constexpr auto SAMPLE_INTERVAL = std::chrono::milliseconds(10);
+
+  struct Event
+  {
+    std::atomic<uint32_t> kind{NONE};
+    uint32_t snapshot;
+    uint64_t start;
+    uint64_t end;
+    uint64_t v[3];
+  };
+
+  class Timeline
+  {
+  public:
+    using Counter = std::function<uint64_t()>;
+    using Percentiles = std::function<bool(uint64_t (&)[3])>;
+
+    static Timeline& instance()
+    {
+      static Timeline t;
+      return t;
+    }
+
+    void record(
+      Kind kind,
+      uint64_t snapshot,
+      uint64_t start,
+      uint64_t end,
+      uint64_t v0 = 0,
+      uint64_t v1 = 0,
+      uint64_t v2 = 0)
+    {
+      size_t slot = next.fetch_add(1, std::memory_order_relaxed);
+      if (slot >= CAPACITY)
+      {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+      auto& e = events[slot];
+      e.snapshot = static_cast<uint32_t>(snapshot);
+      e.start = start;
+      e.end = end;
+      e.v[0] = v0;
+      e.v[1] = v1;
+      e.v[2] = v2;
+      e.kind.store(kind, std::memory_order_release);
+    }
+
+    // Samples throughput from the two cumulative counters, and latency if
+    // `latency` is set, every SAMPLE_INTERVAL
+    void start_sampler(Counter spawned, Counter executed, Percentiles latency)
+    {
+      sampler = std::thread([this, spawned, executed, latency]() {
+        uint64_t prev_t = rdtsc();
+        uint64_t prev_s = spawned(), prev_e = executed();
+        while (!stop.load(std::memory_order_relaxed))
+        {
+          std::this_thread::sleep_for(SAMPLE_INTERVAL);
+          uint64_t t = rdtsc();
+          uint64_t s = spawned(), e = executed();
+          double secs = tsc::to_ns(t - prev_t) / 1e9;
+          if (secs > 0)
+            record(
+              THROUGHPUT,
+              0,
+              prev_t,
+              t,
+              static_cast<uint64_t>((s - prev_s) / secs),
+              static_cast<uint64_t>((e - prev_e) / secs));
+          uint64_t p[3];
+          if (latency && latency(p))
+            record(LATENCY, 0, prev_t, t, p[0], p[1], p[2]);
+          prev_t = t;
+          prev_s = s;
+          prev_e = e;
+        }
+      });
+    }
+
+    void stop_sampler()
+    {
+      stop.store(true, std::memory_order_relaxed);
+      if (sampler.joinable())
+        sampler.join();
+    }
+
+    // Writes every published event, ordered by start time, with times in
+    // microseconds since the timeline was created. Also prints how long
+    // each checkpoint phase took.
+    bool export_csv(const char* path)
+    {
+      size_t n = std::min(next.load(std::memory_order_relaxed), CAPACITY);
+      std::vector<const Event*> sorted;
+      sorted.reserve(n);
+      for (size_t i = 0; i < n; i++)
+        if (events[i].kind.load(std::memory_order_acquire) != NONE)
+          sorted.push_back(&events[i]);
+      std::sort(sorted.begin(), sorted.end(), [](auto* a, auto* b) {
+        return a->start < b->start;
+      });
+
+      FILE* f = fopen(path, "w");
+      if (!f)
+        return false;
+      auto us = [this](uint64_t t) {
+        return t > origin ? tsc::to_ns(t - origin) / 1e3 : 0.0;
+      };
+      fprintf(f, "kind,snapshot,start_us,end_us,duration_us,v0,v1,v2\n");
+      uint64_t count[NUM_KINDS] = {};
+      uint64_t total[NUM_KINDS] = {};
+      uint64_t max[NUM_KINDS] = {};
+      for (auto* e : sorted)
+      {
+        uint32_t k = e->kind.load(std::memory_order_relaxed);
+        uint64_t d = tsc::to_ns(e->end - e->start);
+        fprintf(
+          f,
+          "%s,%u,%.3f,%.3f,%.3f,%lu,%lu,%lu\n",
+          KIND_NAMES[k],
+          e->snapshot,
+          us(e->start),
+          us(e->end),
+          d / 1e3,
+          e->v[0],
+          e->v[1],
+          e->v[2]);
+        count[k]++;
+        total[k] += d;
+        max[k] = std::max(max[k], d);
+      }
+      bool ok = fclose(f) == 0;
+
+      printf("checkpoint phases (ms):      count       mean        max\n");
+      for (uint32_t k = CKPT_COLLECT; k <= GC; k++)
+        if (count[k])
+          printf(
+            "  %-24s %8lu %10.3f %10.3f\n",
+            KIND_NAMES[k],
+            count[k],
+            total[k] / 1e6 / count[k],
+            max[k] / 1e6);
+      if (uint64_t d = dropped.load(std::memory_order_relaxed))
+        printf("timeline: %lu events dropped\n", d);
+      printf("timeline written to %s\n", path);
+      return ok;
+    }
+
+  private:
+    std::unique_ptr<Event[]> events{new Event[CAPACITY]};
+    std::atomic<size_t> next{0};
+    std::atomic<uint64_t> dropped{0};
+    uint64_t origin;
+    std::thread sampler;
+    std::atomic<bool> stop{false};
+
+    Timeline() : origin(rdtsc())
+    {
+      if (!tsc::ns_per_cycle_fp)
+        tsc::calibrate();
+    }
+  };
+
+  inline uint64_t now()
+  {
+    return rdtsc();
+  }
+
+  inline void record(
+    Kind kind,
+    uint64_t snapshot,
+    uint64_t start,
+    uint64_t v0 = 0,
+    uint64_t v1 = 0)
+  {
+    Timeline::instance().record(kind, snapshot, start, rdtsc(), v0, v1);
+  }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <chrono>
+#include <stdint.h>
+#include <stdio.h>
+#include <x86intrin.h>
+
+// Reads the time-stamp counter: ~20 cycles, no syscall, constant rate on
+// invariant-TSC CPUs
+static inline uint64_t rdtsc()
+{
+  return __rdtsc();
+}
+
+namespace tsc
+{
+  // Nanoseconds per cycle and cycles per nanosecond in 32.32 fixed point,
+  // set by calibrate()
+  inline uint64_t ns_per_cycle_fp = 0;
+  inline uint64_t cycles_per_ns_fp = 0;
+
+  // Measures the TSC rate against steady_clock over `window`. Call once at
+  // startup, before any to_ns().
+  inline void calibrate(
+    std::chrono::milliseconds window = std::chrono::milliseconds(50))
+  {
+    auto t0 = std::chrono::steady_clock::now();
+    uint64_t c0 = rdtsc();
+    while (std::chrono::steady_clock::now() - t0 < window)
+      ;
+    uint64_t c1 = rdtsc();
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - t0)
+                .count();
+    ns_per_cycle_fp = (static_cast<uint64_t>(ns) << 32) / (c1 - c0);
+    cycles_per_ns_fp = ((c1 - c0) << 32) / static_cast<uint64_t>(ns);
+    printf("TSC: %.3f GHz\n", static_cast<double>(c1 - c0) / ns);
+  }
+
+  inline uint64_t to_ns(uint64_t cycles)
+  {
+    return static_cast<uint64_t>(
+      (static_cast<unsigned __int128>(cycles) * ns_per_cycle_fp) >> 32);
+  }
+
+  inline uint64_t to_cycles(uint64_t ns)
+  {
+    return static_cast<uint64_t>(
+      (static_cast<unsigned __int128>(ns) * cycles_per_ns_fp) >> 32);
+  }
+}
@@ -1,18 +1,17 @@
 #pragma once
 
 #include "config.hpp"
+#include "latency_histogram.hpp"
+#include "tsc.hpp"
+#include "perf_counters.hpp"
+#include "worker_counters.hpp"
 
 #include <mutex>
 #include <thread>
 #include <unordered_map>
 
-extern std::unordered_map<std::thread::id, uint64_t*>* counter_map;
 extern std::unordered_map<std::thread::id, log_arr_type*>* log_map;
-extern std::mutex* counter_map_mutex;
-const int SAMPLE_RATE = 10;
-
-// Global start time for timestamp logging
-extern ts_type benchmark_start_time;
+extern std::mutex* log_map_mutex;
 
 /* Thread-local singleton TxCounter */
 struct TxCounter
@@ -25,7 +24,19 @@ struct TxCounter
 
   void incr()
   {
-    tx_cnt++;
+    WorkerSlot::bump(slot->executed);
+  }
+
+  // Counts an executed transaction of workload-defined type `type`
+  void incr(size_t type)
+  {
+    WorkerSlot::bump(slot->executed);
+    WorkerSlot::bump(slot->by_type[type]);
+  }
+
+  void abort()
+  {
+    WorkerSlot::bump(slot->aborted);
   }
 
 #ifdef LOG_LATENCY
@@ -35,44 +46,51 @@ struct TxCounter
     log_arr->push_back({exec_time, txn_time});
   }
 #  else
-  void log_latency(ts_type init_time)
+  // Records the latency of every transaction, from its arrival (init_time,
+  // a TSC value from the ArrivalLog) to completion, into this worker's
+  // histogram
+  void log_latency(uint64_t init_time)
   {
-    if (tx_cnt % SAMPLE_RATE == 0)
-    {
-      auto time_now = std::chrono::system_clock::now();
-      std::chrono::duration<double> duration = time_now - benchmark_start_time;
-      uint64_t timestamp_us =
-        static_cast<uint64_t>(duration.count() * 1'000'000);
-
-      log_arr->push_back(timestamp_us);
-    }
+    uint64_t now = rdtsc();
+    hist->record(now > init_time ? tsc::to_ns(now - init_time) : 0);
   }
 #  endif
 #endif
 
 private:
-  uint64_t tx_cnt;
+  WorkerSlot* slot;
 #ifdef LOG_LATENCY
+#  ifdef LOG_SCHED_OHEAD
   log_arr_type* log_arr;
+#  else
+  LatencyHistogram* hist;
+#  endif
 #endif
 
   TxCounter()
   {
-    tx_cnt = 0;
-    std::lock_guard<std::mutex> lock(*counter_map_mutex);
-    (*counter_map)[std::this_thread::get_id()] = &tx_cnt;
+    slot = WorkerCounters::instance().claim();
 #ifdef LOG_LATENCY
+#  ifdef LOG_SCHED_OHEAD
     log_arr = new log_arr_type();
     log_arr->reserve(TX_COUNTER_LOG_SIZE);
-    (*log_map)[std::this_thread::get_id()] = log_arr;
+    {
+      std::lock_guard<std::mutex> lock(*log_map_mutex);
+      (*log_map)[std::this_thread::get_id()] = log_arr;
+    }
+#  else
+    hist = LatencyHistograms::instance().register_thread();
+#  endif
+#endif
+#ifdef PERF_COUNTERS
+    perf::Registry::instance().attach("worker");
 #endif
   }
 
   ~TxCounter() noexcept
   {
-    std::lock_guard<std::mutex> lock(*counter_map_mutex);
-    counter_map->erase(std::this_thread::get_id());
-#ifdef LOG_LATENCY
+#if defined(LOG_LATENCY) && defined(LOG_SCHED_OHEAD)
+    std::lock_guard<std::mutex> lock(*log_map_mutex);
     log_map->erase(std::this_thread::get_id());
 #endif
   }
@@ -0,0 +1,246 @@
+#pragma once
+
+#include "tsc.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+// Sampled per-transaction lifecycle tracing, compiled in with TXN_TRACE.
+//
+// Transactions are numbered in arrival order; every stage sees them in that
+// order, so each one can tell from its own running count whether a
+// transaction is sampled (one in DORADD_TRACE_SAMPLE, default 1024, rounded
+// up to a power of two). A sampled transaction gets a timestamped record at
+// arrival, indexing, prefetching, spawning, behaviour start and behaviour
+// end, tagged with the recording thread.
+//
+// Each thread appends 16-byte records to its own single-producer ring; a
+// background thread drains the rings into a binary file which
+// parse_txn_trace.py turns into per-stage latency breakdowns. A full ring
+// drops records rather than stall the pipeline, and the drops are counted.
+//
+// File layout: header {u32 magic, u32 version, u32 sample, u32 0,
+// u64 ns_per_cycle (32.32 fixed point)}, then Records, then a footer of
+// {u16 thread id, char name[14]} per thread, u32 thread count, u32 magic.
+namespace txn_trace
+{
+  enum Event : uint8_t
+  {
+    ARRIVAL,
+    INDEXED,
+    PREFETCHED,
+    SPAWNED,
+    BEGIN,
+    END,
+  };
+
+  struct Record
+  {
+    uint64_t tsc;
+    uint32_t sample; // transaction number / sample rate
+    uint16_t thread;
+    uint8_t event;
+    uint8_t pad;
+  };
+  static_assert(sizeof(Record) == 16);
+
+  static constexpr uint32_t FILE_MAGIC = 0x54585452; // "TXTR"
+  static constexpr uint32_t FILE_VERSION = 1;
+  static constexpr uint64_t NOT_SAMPLED = ~0ull;
+
+#ifdef TXN_TRACE
+  static constexpr size_t RING_SIZE = 1 << 16; // records per thread
+  static constexpr auto FLUSH_INTERVAL = std::chrono::milliseconds(10);
+
+  struct alignas(64) Ring
+  {
+    char name[14] = {};
+    uint16_t id = 0;
+    std::atomic<uint64_t> head{0}; // written by the owner
+    alignas(64) std::atomic<uint64_t> tail{0}; // written by the flusher
+    uint64_t dropped = 0;
+    Record records[RING_SIZE];
+  };
+
+  class Tracer
+  {
+  public:
+    static Tracer& instance()
+    {
+      static Tracer t;
+      return t;
+    }
+
+    uint64_t mask = 1023;
+    uint32_t shift = 10;
+
+    Ring* add_ring(const char* name)
+    {
+      auto ring = std::make_unique<Ring>();
+      strncpy(ring->name, name, sizeof(ring->name) - 1);
+      std::lock_guard<std::mutex> lock(mu);
+      ring->id = static_cast<uint16_t>(rings.size());
+      rings.push_back(std::move(ring));
+      return rings.back().get();
+    }
+
+    void start(const char* path)
+    {
+      if (const char* env = std::getenv("DORADD_TRACE_SAMPLE"))
+      {
+        uint64_t n = std::max(1L, std::atol(env));
+        shift = n > 1 ? 64 - __builtin_clzll(n - 1) : 0;
+        mask = (1ull << shift) - 1;
+      }
+      if (tsc::cycles_per_ns_fp == 0)
+        tsc::calibrate();
+      out = fopen(path, "wb");
+      if (!out)
+      {
+        fprintf(stderr, "txn_trace: cannot open %s\n", path);
+        return;
+      }
+      uint32_t header[4] = {
+        FILE_MAGIC, FILE_VERSION, static_cast<uint32_t>(mask + 1), 0};
+      fwrite(header, sizeof(header), 1, out);
+      fwrite(&tsc::ns_per_cycle_fp, sizeof(uint64_t), 1, out);
+      flusher = std::thread([this]() {
+        while (!stop_flag.load(std::memory_order_relaxed))
+        {
+          flush();
+          std::this_thread::sleep_for(FLUSH_INTERVAL);
+        }
+      });
+      printf("txn_trace: sampling 1 in %lu transactions into %s\n", mask + 1, path);
+    }
+
+    void stop()
+    {
+      if (!out)
+        return;
+      stop_flag.store(true, std::memory_order_relaxed);
+      if (flusher.joinable())
+        flusher.join();
+      flush();
+      std::lock_guard<std::mutex> lock(mu);
+      uint64_t dropped = 0;
+      for (auto& r : rings)
+      {
+        fwrite(&r->id, sizeof(r->id), 1, out);
+        fwrite(r->name, sizeof(r->name), 1, out);
+        dropped += r->dropped;
+      }
+      uint32_t footer[2] = {static_cast<uint32_t>(rings.size()), FILE_MAGIC};
+      fwrite(footer, sizeof(footer), 1, out);
+      fclose(out);
+      out = nullptr;
+      if (dropped)
+        fprintf(stderr, "txn_trace: %lu records dropped\n", dropped);
+    }
+
+  private:
+    std::mutex mu;
+    std::vector<std::unique_ptr<Ring>> rings;
+    FILE* out = nullptr;
+    std::thread flusher;
+    std::atomic<bool> stop_flag{false};
+
+    void flush()
+    {
+      std::lock_guard<std::mutex> lock(mu);
+      for (auto& r : rings)
+      {
+        uint64_t tail = r->tail.load(std::memory_order_relaxed);
+        uint64_t head = r->head.load(std::memory_order_acquire);
+        while (tail != head)
+        {
+          size_t start = tail % RING_SIZE;
+          size_t n = std::min<uint64_t>(head - tail, RING_SIZE - start);
+          fwrite(&r->records[start], sizeof(Record), n, out);
+          tail += n;
+        }
+        r->tail.store(tail, std::memory_order_release);
+      }
+    }
+  };
+
+  // The calling thread's ring, registered on first use
+  inline Ring* thread_ring(const char* name)
+  {
+    static thread_local Ring* ring = Tracer::instance().add_ring(name);
+    return ring;
+  }
+
+  inline void
+  emit(Event e, uint64_t txn, const char* thread_name, uint64_t at = rdtsc())
+  {
+    Ring* r = thread_ring(thread_name);
+    uint64_t head = r->head.load(std::memory_order_relaxed);
+    if (head - r->tail.load(std::memory_order_acquire) >= RING_SIZE)
+    {
+      r->dropped++;
+      return;
+    }
+    auto& rec = r->records[head % RING_SIZE];
+    rec.tsc = at;
+    rec.sample = static_cast<uint32_t>(txn >> Tracer::instance().shift);
+    rec.thread = r->id;
+    rec.event = e;
+    r->head.store(head + 1, std::memory_order_release);
+  }
+
+  inline bool sampled(uint64_t txn)
+  {
+    return (txn & Tracer::instance().mask) == 0;
+  }
+
+  // Records event `e` for transaction number `txn` if it is sampled, at
+  // time `at` (default: now)
+  inline void
+  point(Event e, uint64_t txn, const char* thread_name, uint64_t at = rdtsc())
+  {
+    if (sampled(txn))
+      emit(e, txn, thread_name, at);
+  }
+
+  // Transaction number handed from the spawner to the behaviour it creates
+  inline thread_local uint64_t spawning = NOT_SAMPLED;
+
+  inline void spawn(uint64_t txn)
+  {
+    spawning = sampled(txn) ? txn : NOT_SAMPLED;
+    if (spawning != NOT_SAMPLED)
+      emit(SPAWNED, txn, "spawner");
+  }
+
+  inline void behaviour(Event e, uint64_t txn)
+  {
+    if (txn != NOT_SAMPLED)
+      emit(e, txn, "worker");
+  }
+#else
+  inline void point(Event, uint64_t, const char*, uint64_t = 0) {}
+  inline void spawn(uint64_t) {}
+#endif
+}
+
+// Applications add TXN_TRACE_CAPTURE to the capture list of the behaviour
+// they spawn and bracket its body with TXN_TRACE_BEGIN/END
+#ifdef TXN_TRACE
+#  define TXN_TRACE_CAPTURE , trace_txn = txn_trace::spawning
+#  define TXN_TRACE_BEGIN() txn_trace::behaviour(txn_trace::BEGIN, trace_txn)
+#  define TXN_TRACE_END() txn_trace::behaviour(txn_trace::END, trace_txn)
+#else
+#  define TXN_TRACE_CAPTURE
+#  define TXN_TRACE_BEGIN()
+#  define TXN_TRACE_END()
+#endif
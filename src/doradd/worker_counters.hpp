@@ -0,0 +1,116 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <stddef.h>
+#include <stdint.h>
+
+// Per-worker transaction counters.
+//
+// Slots live in one fixed array, each on its own cache lines, so a worker
+// never shares a line with another worker or with unrelated thread-local
+// data. A slot has a single writer (its worker), which bumps counters with
+// relaxed load + store; readers sum them with relaxed loads at any time,
+// without locks. Summing MAX_WORKERS slots is a few hundred loads, cheap
+// enough to poll every millisecond.
+//
+// init() sizes the registry when the scheduler starts; each worker thread
+// claims the next free slot the first time it counts a transaction.
+static constexpr size_t MAX_WORKERS = 128;
+static constexpr size_t MAX_TXN_TYPES = 8;
+
+struct alignas(64) WorkerSlot
+{
+  std::atomic<uint64_t> executed{0};
+  std::atomic<uint64_t> aborted{0};
+  std::array<std::atomic<uint64_t>, MAX_TXN_TYPES> by_type{};
+
+  static void bump(std::atomic<uint64_t>& c)
+  {
+    c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+};
+
+class WorkerCounters
+{
+public:
+  struct Totals
+  {
+    uint64_t executed = 0;
+    uint64_t aborted = 0;
+    std::array<uint64_t, MAX_TXN_TYPES> by_type{};
+  };
+
+  static WorkerCounters& instance()
+  {
+    static WorkerCounters c;
+    return c;
+  }
+
+  void init(size_t workers)
+  {
+    if (workers > MAX_WORKERS)
+    {
+      fprintf(stderr, "WorkerCounters: at most %zu workers\n", MAX_WORKERS);
+      exit(1);
+    }
+    expected = workers;
+  }
+
+  // Slot of the calling worker, claimed on first use
+  WorkerSlot* claim()
+  {
+    size_t id = claimed.fetch_add(1, std::memory_order_relaxed);
+    if (id >= MAX_WORKERS)
+    {
+      fprintf(stderr, "WorkerCounters: more than %zu workers\n", MAX_WORKERS);
+      exit(1);
+    }
+    return &slots[id];
+  }
+
+  // Workers that have counted at least one transaction
+  size_t registered() const
+  {
+    return std::min(claimed.load(std::memory_order_relaxed), MAX_WORKERS);
+  }
+
+  bool all_registered() const
+  {
+    return registered() >= expected;
+  }
+
+  uint64_t executed() const
+  {
+    uint64_t sum = 0;
+    for (size_t i = 0, n = registered(); i < n; i++)
+      sum += slots[i].executed.load(std::memory_order_relaxed);
+    return sum;
+  }
+
+  Totals totals() const
+  {
+    Totals t;
+    for (size_t i = 0, n = registered(); i < n; i++)
+    {
+      t.executed += slots[i].executed.load(std::memory_order_relaxed);
+      t.aborted += slots[i].aborted.load(std::memory_order_relaxed);
+      for (size_t k = 0; k < MAX_TXN_TYPES; k++)
+        t.by_type[k] += slots[i].by_type[k].load(std::memory_order_relaxed);
+    }
+    return t;
+  }
+
+  const WorkerSlot& slot(size_t id) const
+  {
+    return slots[id];
+  }
+
+private:
+  std::array<WorkerSlot, MAX_WORKERS> slots;
+  std::atomic<size_t> claimed{0};
+  size_t expected = 0;
+};
@@ -292,6 +292,145 @@ static void gamma_init(struct rand_gen *gen, struct param_2 *param)
 	free(param);
 }
 
+/*
+ * Trace replay: trace:<file>[:<scale>]
+ * The file holds recorded arrival times as native u64 nanoseconds in
+ * non-decreasing order. Gaps are replayed multiplied by scale (default 1);
+ * at the end the trace restarts after its mean gap.
+ */
+static double trace_generate(struct rand_gen *gen)
+{
+	/* rand_gen is packed: go through gen rather than a member pointer */
+	uint64_t i = gen->params.tp.pos;
+	double gap;
+
+	if (i + 1 < gen->params.tp.n) {
+		gap = gen->params.tp.ts[i + 1] - gen->params.tp.ts[i];
+		gen->params.tp.pos++;
+	} else {
+		gap = gen->params.tp.wrap_gap;
+		gen->params.tp.pos = 0;
+	}
+	return gap * gen->params.tp.scale;
+}
+
+static int trace_init(struct rand_gen *gen, char *type)
+{
+	struct trace_params p;
+	char *path, *tok;
+	FILE *f;
+	long size;
+	uint64_t i;
+
+	strtok(type, ":");
+	path = strtok(NULL, ":");
+	tok = strtok(NULL, ":");
+	if (!path) {
+		lancet_fprintf(stderr, "Usage: trace:<file>[:<scale>]\n");
+		return -1;
+	}
+	f = fopen(path, "rb");
+	if (!f) {
+		lancet_fprintf(stderr, "Cannot open trace %s\n", path);
+		return -1;
+	}
+	if (fseek(f, 0, SEEK_END) != 0 || (size = ftell(f)) < 0 ||
+		fseek(f, 0, SEEK_SET) != 0) {
+		lancet_fprintf(stderr, "Cannot size trace %s\n", path);
+		fclose(f);
+		return -1;
+	}
+	p.n = size / sizeof(uint64_t);
+	if (p.n < 2) {
+		lancet_fprintf(stderr, "Trace %s needs at least 2 timestamps\n", path);
+		fclose(f);
+		return -1;
+	}
+	p.ts = (uint64_t *)malloc(p.n * sizeof(uint64_t));
+	assert(p.ts);
+	if (fread(p.ts, sizeof(uint64_t), p.n, f) != p.n) {
+		lancet_fprintf(stderr, "Cannot read trace %s\n", path);
+		free(p.ts);
+		fclose(f);
+		return -1;
+	}
+	fclose(f);
+	for (i = 1; i < p.n; i++) {
+		if (p.ts[i] < p.ts[i - 1]) {
+			lancet_fprintf(stderr, "Trace %s is not sorted at %lu\n", path, i);
+			free(p.ts);
+			return -1;
+		}
+	}
+	p.pos = 0;
+	p.scale = (tok == NULL) ? 1 : atof(tok);
+	p.wrap_gap = (double)(p.ts[p.n - 1] - p.ts[0]) / (p.n - 1);
+
+	gen->params.tp = p;
+	gen->generate = trace_generate;
+	gen->set_avg = NULL;
+	gen->inv_cdf = NULL;
+	gen->gen_type = GEN_TRACE;
+	return 0;
+}
+
+/*
+ * Markov-modulated on/off bursts:
+ * onoff:<on_gap_ns>:<on_ns>:<off_ns>[:<off_gap_ns>]
+ * Arrivals are Poisson with mean gap on_gap_ns while on and off_gap_ns
+ * (default: none) while off; on and off periods are exponential with means
+ * on_ns and off_ns.
+ */
+static double onoff_generate(struct rand_gen *gen)
+{
+	/* rand_gen is packed: work on a copy rather than a member pointer */
+	struct onoff_params p = gen->params.oo;
+	double gap = 0, g;
+
+	for (;;) {
+		g = p.gap[p.state] > 0 ?
+			-log(1.0 - drand48()) * p.gap[p.state] : INFINITY;
+		if (g <= p.left) {
+			p.left -= g;
+			gen->params.oo = p;
+			return gap + g;
+		}
+		gap += p.left;
+		p.state ^= 1;
+		p.left = -log(1.0 - drand48()) * p.dwell[p.state];
+	}
+}
+
+static int onoff_init(struct rand_gen *gen, char *type)
+{
+	struct onoff_params p;
+	double v[4] = {0, 0, 0, 0};
+	char *tok;
+	int n = 0;
+
+	strtok(type, ":");
+	while (n < 4 && (tok = strtok(NULL, ":")) != NULL)
+		v[n++] = atof(tok);
+	if (n < 3 || v[0] <= 0 || v[1] <= 0 || v[2] <= 0) {
+		lancet_fprintf(stderr,
+			"Usage: onoff:<on_gap_ns>:<on_ns>:<off_ns>[:<off_gap_ns>]\n");
+		return -1;
+	}
+	p.gap[1] = v[0];
+	p.dwell[1] = v[1];
+	p.dwell[0] = v[2];
+	p.gap[0] = v[3];
+	p.state = 1;
+	p.left = -log(1.0 - drand48()) * p.dwell[1];
+
+	gen->params.oo = p;
+	gen->generate = onoff_generate;
+	gen->set_avg = NULL;
+	gen->inv_cdf = NULL;
+	gen->gen_type = GEN_ONOFF;
+	return 0;
+}
+
 static struct param_1 *parse_param_1(char *type)
 {
 	char *tok;
@@ -376,7 +515,17 @@ struct rand_gen *lancet_init_rand(char *gen_type)
 		lognormal_init(gen, parse_param_2(gen_type));
 	else if (strncmp(gen_type, "gamma", 5) == 0)
 		gamma_init(gen, parse_param_2(gen_type));
-	else {
+	else if (strncmp(gen_type, "trace", 5) == 0) {
+		if (trace_init(gen, gen_type)) {
+			free(gen);
+			return NULL;
+		}
+	} else if (strncmp(gen_type, "onoff", 5) == 0) {
+		if (onoff_init(gen, gen_type)) {
+			free(gen);
+			return NULL;
+		}
+	} else {
 		lancet_fprintf(stderr, "Unknown generator type %s\n", gen_type);
 		return NULL;
 	}
@@ -31,6 +31,9 @@ enum {
 	GEN_OTHER = 0,
 	GEN_FIXED,
 	GEN_EXP,
+	/* Stateful across samples: one generator must produce the sequence */
+	GEN_TRACE,
+	GEN_ONOFF,
 };
 
 struct param_1 {
@@ -70,6 +73,21 @@ struct gamma_params {
 	struct cpp_gen *gg;
 };
 
+struct trace_params {
+	uint64_t *ts;
+	uint64_t n;
+	uint64_t pos;
+	double scale;
+	double wrap_gap;
+};
+
+struct onoff_params {
+	double gap[2];   /* mean inter-arrival in the off/on state, 0 = none */
+	double dwell[2]; /* mean time spent in the off/on state */
+	double left;     /* time left in the current state */
+	int state;
+};
+
 union rand_params {
 	struct param_1 p1;
 	struct param_2 p2;
@@ -78,6 +96,8 @@ union rand_params {
 	struct bimodal_param bp;
 	struct lognorm_params lgp;
 	struct gamma_params gp;
+	struct trace_params tp;
+	struct onoff_params oo;
 };
 
 struct __attribute__((packed)) rand_gen {
@@ -121,3 +141,15 @@ static inline double generate(struct rand_gen *generator)
 		return generator->inv_cdf(generator, y);
 	}
 }
+
+/*
+ * Same as generate(), but draws from caller-owned erand48() state instead of
+ * the process-wide drand48() one, so several threads can sample at once
+ */
+static inline double generate_r(struct rand_gen *generator,
+								unsigned short xsubi[3])
+{
+	if (generator->generate)
+		return generator->generate(generator);
+	return generator->inv_cdf(generator, erand48(xsubi));
+}
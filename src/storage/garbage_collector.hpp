@@ -1,94 +1,64 @@
 #pragma once
 
-#include <thread>
-#include <atomic>
-#include <chrono>
+#include <cstdint>
+#include <cstdlib>
 #include <iostream>
-#include <unordered_map>
+#include <string>
 #include <vector>
-#include <algorithm>
-#include "rocksdb.hpp"
+#include "snapshot_manifest.hpp"
 
+// Reclaims checkpoint snapshots. Every snapshot lives under its own key
+// prefix (see snapshot_manifest.hpp), so dropping one is a single range
+// delete and the work is proportional to the number of snapshots reclaimed,
+// never to the number of rows stored.
+template<typename StorageType>
 class GarbageCollector {
 public:
-    static constexpr int GC_INTERVAL_SECONDS = 100;  // Run GC every 5 minutes
-    static constexpr int KEEP_VERSIONS = 2;  // Keep K-2 versions
-    static constexpr const char* GLOBAL_SNAPSHOT_KEY = "global_snapshot";
+    explicit GarbageCollector(StorageType& store) : storage(store) {}
 
-    GarbageCollector(RocksDBStore& store) : storage(store), stop_gc(false) {
-        // Start GC thread
-        gc_thread = std::thread([this]() {
-            while (!stop_gc) {
-                std::this_thread::sleep_for(std::chrono::seconds(GC_INTERVAL_SECONDS));
-                if (!stop_gc) {
-                    run_gc();
-                }
-            }
-        });
+    // Drops the given snapshots, e.g. the ones just folded into a new base.
+    void reclaim(char kind, const std::vector<uint64_t>& snaps) {
+        for (uint64_t snap : snaps)
+            storage.delete_prefix(snapshot_keys::prefix(kind, snap));
     }
 
-    ~GarbageCollector() {
-        // Stop GC thread
-        stop_gc = true;
-        if (gc_thread.joinable()) {
-            gc_thread.join();
+    // Drops every snapshot the manifest does not reference: rows of a
+    // checkpoint or fold that crashed before committing the manifest, and
+    // folded snapshots whose deletion was interrupted. Only call this while
+    // nothing is writing snapshots, i.e. before checkpointing starts.
+    size_t collect_orphans(const SnapshotManifest& live) {
+        size_t dropped = 0;
+        for (const std::string& group : storage.list_groups()) {
+            char kind;
+            uint64_t snap;
+            if (!parse_group(group, kind, snap)) continue;
+            if (kind == snapshot_keys::BASE && snap == live.base && live.base) continue;
+            if (kind == snapshot_keys::INCREMENTAL && is_live_incremental(live, snap)) continue;
+            storage.delete_prefix(group + "/");
+            ++dropped;
         }
+        if (dropped) {
+            storage.flush();
+            std::cout << "GC: reclaimed " << dropped << " orphaned snapshot(s)" << std::endl;
+        }
+        return dropped;
     }
 
 private:
-    void run_gc() {
-        // Read the current global snapshot
-        std::string snap_str;
-        if (!storage.get(GLOBAL_SNAPSHOT_KEY, snap_str)) {
-            std::cerr << "Failed to read global snapshot during GC" << std::endl;
-            return;
-        }
-
-        uint64_t current_snapshot = std::stoull(snap_str);
-        uint64_t prune_threshold = current_snapshot - KEEP_VERSIONS;
-        
-        if (prune_threshold <= 0) {
-            return;  // No versions to prune yet
-        }
-
-        // First pass: collect all versions of each row
-        std::unordered_map<uint64_t, std::vector<std::pair<uint64_t, std::string>>> row_versions;
-        for (auto& kv : storage.scan_prefix("")) {
-            const std::string& key = kv.first;
-            if (key == GLOBAL_SNAPSHOT_KEY || key == "total_txns") continue;
-
-            auto pos = key.rfind("_v");
-            if (pos == std::string::npos) continue;
-
-            uint64_t row_id = std::stoull(key.substr(0, pos));
-            uint64_t version_id = std::stoull(key.substr(pos + 2));
-            
-            if (version_id <= prune_threshold) {
-                row_versions[row_id].emplace_back(version_id, key);
-            }
-        }
-
-        // Second pass: delete old versions
-        rocksdb::WriteBatch batch;
-        for (const auto& [row_id, versions] : row_versions) {
-            // Sort versions by version_id
-            std::vector<std::pair<uint64_t, std::string>> sorted_versions = versions;
-            std::sort(sorted_versions.begin(), sorted_versions.end());
-
-            // Keep the newest version below threshold
-            for (size_t i = 0; i < sorted_versions.size() - 1; i++) {
-                batch.Delete(sorted_versions[i].second);
-            }
-        }
+    static bool parse_group(const std::string& group, char& kind, uint64_t& snap) {
+        if (group.size() != 17) return false;
+        kind = group[0];
+        if (kind != snapshot_keys::BASE && kind != snapshot_keys::INCREMENTAL) return false;
+        char* end;
+        snap = std::strtoull(group.c_str() + 1, &end, 16);
+        return *end == '\0';
+    }
 
-        // Commit the batch
-        if (batch.Count() > 0) {
-            storage.commit_batch(batch);
-            std::cout << "GC completed: pruned old versions up to snapshot " << prune_threshold << std::endl;
-        }
+    static bool is_live_incremental(const SnapshotManifest& live, uint64_t snap) {
+        for (uint64_t s : live.incrementals)
+            if (s == snap) return true;
+        return false;
     }
 
-    RocksDBStore& storage;
-    std::thread gc_thread;
-    std::atomic<bool> stop_gc;
-}; 
\ No newline at end of file
+    StorageType& storage;
+};
@@ -6,15 +6,31 @@
 #include <rocksdb/slice.h>
 #include <rocksdb/status.h>
 #include <rocksdb/write_batch.h>
+#include <rocksdb/sst_file_writer.h>
+#include <rocksdb/convenience.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <vector>
 #include <memory>
+#include <mutex>
 #include <iostream>
 
 class RocksDBStore {
+public:
+    static constexpr size_t BULK_WRITERS = 4;  // SST files written in parallel per ingestion
+
 private:
     rocksdb::DB* db_;
     rocksdb::Options options_;
+    std::string db_path_;
+    std::atomic<uint64_t> next_sst_id_{0};
 
 public:
     RocksDBStore() : db_(nullptr) {
@@ -34,6 +50,7 @@ public:
             std::cerr << "RocksDB: Failed to open DB: " << status.ToString() << std::endl;
             return false;
         }
+        db_path_ = db_path;
         return true;
     }
 
@@ -118,16 +135,246 @@ public:
         return true;
     }
 
+    using Rows = std::vector<std::pair<std::string, std::string>>;
+
+    // Bulk path for large checkpoints. Rows are handed over in sorted ranges
+    // that do not overlap each other, as soon as each range is complete;
+    // BULK_WRITERS threads write every range straight into its own SST file
+    // while later ranges are still being produced, and finish() attaches all
+    // files with one IngestExternalFile, bypassing the WAL and memtable.
+    class BulkLoad {
+        RocksDBStore& store_;
+        std::string dir_;
+        std::mutex mu_;
+        std::condition_variable cv_;
+        std::deque<Rows> queue_;
+        bool closing_ = false;
+        bool ok_ = true;
+        std::vector<std::string> files_;
+        std::vector<std::thread> writers_;
+
+        void write_ranges() {
+            while (true) {
+                Rows rows;
+                {
+                    std::unique_lock<std::mutex> lk(mu_);
+                    cv_.wait(lk, [this]() { return closing_ || !queue_.empty(); });
+                    if (queue_.empty()) return;
+                    rows = std::move(queue_.front());
+                    queue_.pop_front();
+                }
+                std::string file = dir_ + "/" + std::to_string(store_.next_sst_id_.fetch_add(1)) + ".sst";
+                rocksdb::SstFileWriter writer(rocksdb::EnvOptions(), store_.options_);
+                rocksdb::Status s = writer.Open(file);
+                for (size_t i = 0; s.ok() && i < rows.size(); ++i)
+                    s = writer.Put(rows[i].first, rows[i].second);
+                if (s.ok()) s = writer.Finish();
+                std::lock_guard<std::mutex> lg(mu_);
+                files_.push_back(file);
+                if (!s.ok()) {
+                    std::cerr << "RocksDB: Failed to write SST file: " << s.ToString() << std::endl;
+                    ok_ = false;
+                }
+            }
+        }
+
+    public:
+        explicit BulkLoad(RocksDBStore& store) : store_(store), dir_(store.db_path_ + "/ingest") {
+            std::filesystem::create_directories(dir_);
+            for (size_t w = 0; w < BULK_WRITERS; ++w)
+                writers_.emplace_back([this]() { write_ranges(); });
+        }
+
+        ~BulkLoad() {
+            if (!writers_.empty()) finish();
+        }
+
+        // `rows` must be sorted by key, without duplicates, and lie outside
+        // every other range. Safe to call from several threads.
+        void add_range(Rows&& rows) {
+            if (rows.empty()) return;
+            {
+                std::lock_guard<std::mutex> lg(mu_);
+                queue_.push_back(std::move(rows));
+            }
+            cv_.notify_one();
+        }
+
+        // Waits for every range to be written and ingests them. False if
+        // any file failed, in which case nothing is ingested.
+        bool finish() {
+            {
+                std::lock_guard<std::mutex> lg(mu_);
+                closing_ = true;
+            }
+            cv_.notify_all();
+            for (auto& t : writers_) t.join();
+            writers_.clear();
+
+            if (!store_.db_) ok_ = false;
+            if (ok_ && !files_.empty()) {
+                rocksdb::IngestExternalFileOptions ifo;
+                ifo.move_files = true;
+                rocksdb::Status status = store_.db_->IngestExternalFile(files_, ifo);
+                if (!status.ok()) {
+                    std::cerr << "RocksDB: Failed to ingest SST files: " << status.ToString() << std::endl;
+                    ok_ = false;
+                }
+            }
+            // Moved files are already linked into the DB; drop leftovers
+            for (auto& f : files_) std::filesystem::remove(f);
+            files_.clear();
+            return ok_;
+        }
+    };
+
+    std::shared_ptr<BulkLoad> begin_bulk() {
+        return std::make_shared<BulkLoad>(*this);
+    }
+
+    // Ingests `entries`, sorted by key and without duplicates, through a
+    // BulkLoad split into BULK_WRITERS ranges
+    bool ingest_sorted(const Rows& entries) {
+        if (!db_) return false;
+        if (entries.empty()) return true;
+        auto bulk = begin_bulk();
+        size_t per_writer = (entries.size() + BULK_WRITERS - 1) / BULK_WRITERS;
+        for (size_t lo = 0; lo < entries.size(); lo += per_writer) {
+            size_t hi = std::min(entries.size(), lo + per_writer);
+            bulk->add_range(Rows(entries.begin() + lo, entries.begin() + hi));
+        }
+        return bulk->finish();
+    }
+
+    // Smallest key greater than every key starting with `prefix`
+    static std::string prefix_upper_bound(std::string prefix) {
+        while (!prefix.empty() && static_cast<unsigned char>(prefix.back()) == 0xff)
+            prefix.pop_back();
+        if (!prefix.empty()) prefix.back()++;
+        return prefix;
+    }
+
+    // Sorted, streaming view over the keys in [begin, end); an empty `end`
+    // is unbounded. Uses readahead and skips the block cache since scans here
+    // read each block once (recovery, merging, GC).
+    class Cursor {
+        std::unique_ptr<std::string> upper_;
+        std::unique_ptr<rocksdb::Slice> upper_slice_;
+        std::unique_ptr<rocksdb::Iterator> it_;
+
+    public:
+        Cursor(rocksdb::DB* db, const std::string& begin, const std::string& end) {
+            rocksdb::ReadOptions ro;
+            ro.readahead_size = SCAN_READAHEAD;
+            ro.fill_cache = false;
+            if (!end.empty()) {
+                upper_ = std::make_unique<std::string>(end);
+                upper_slice_ = std::make_unique<rocksdb::Slice>(*upper_);
+                ro.iterate_upper_bound = upper_slice_.get();
+            }
+            if (db) {
+                it_.reset(db->NewIterator(ro));
+                it_->Seek(begin);
+            }
+        }
+
+        bool valid() const { return it_ && it_->Valid(); }
+        std::string_view key() const { return std::string_view(it_->key().data(), it_->key().size()); }
+        std::string_view value() const { return std::string_view(it_->value().data(), it_->value().size()); }
+        void next() { it_->Next(); }
+    };
+
+    static constexpr size_t SCAN_READAHEAD = 2 << 20;
+
+    Cursor cursor(const std::string& prefix) {
+        return Cursor(db_, prefix, prefix_upper_bound(prefix));
+    }
+
+    // Streams every entry starting with `prefix` to visit(key, value)
+    // without materializing it. The views are only valid during the call.
+    template<typename Visitor>
+    void for_each_prefix(const std::string& prefix, Visitor&& visit) {
+        for (Cursor c = cursor(prefix); c.valid(); c.next())
+            visit(c.key(), c.value());
+    }
+
+    // Splits the keys starting with `prefix` into `parts` ranges and scans
+    // them concurrently. `visit` is called from several threads, and each
+    // range is visited in key order. Split points are interpolated on the
+    // first 8 bytes after the common prefix of the first and last key, or on
+    // the first 16 digits when both keys continue in lowercase hex (snapshot
+    // row ids), where raw bytes would put most split points in the gap
+    // between '9' and 'a'.
+    template<typename Visitor>
+    void parallel_for_each_prefix(const std::string& prefix, size_t parts, Visitor&& visit) {
+        if (!db_) return;
+        std::string end = prefix_upper_bound(prefix);
+        std::string first, last;
+        {
+            Cursor c(db_, prefix, end);
+            if (!c.valid()) return;
+            first = c.key();
+            rocksdb::ReadOptions ro;
+            std::unique_ptr<rocksdb::Iterator> it(db_->NewIterator(ro));
+            if (end.empty()) it->SeekToLast(); else it->SeekForPrev(end);
+            if (it->Valid() && it->key().ToString() == end) it->Prev();
+            last = it->Valid() ? it->key().ToString() : first;
+        }
+
+        size_t common = 0;
+        while (common < first.size() && common < last.size() && first[common] == last[common]) ++common;
+        static constexpr char HEX[] = "0123456789abcdef";
+        auto is_hex = [&](const std::string& k) {
+            if (k.size() <= common) return false;
+            for (size_t i = common; i < k.size() && i < common + 16; ++i)
+                if (!strchr(HEX, k[i]) || !k[i]) return false;
+            return true;
+        };
+        bool hex = is_hex(first) && is_hex(last);
+        size_t width = hex ? 16 : 8;
+        auto window = [&](const std::string& k) {
+            uint64_t v = 0;
+            for (size_t i = 0; i < width; ++i) {
+                if (common + i >= k.size()) {
+                    v = hex ? v << 4 : v << 8;
+                    continue;
+                }
+                unsigned char c = static_cast<unsigned char>(k[common + i]);
+                v = hex ? (v << 4) | static_cast<uint64_t>(strchr(HEX, c) - HEX) : (v << 8) | c;
+            }
+            return v;
+        };
+        uint64_t lo = window(first), hi = window(last);
+        parts = std::max<size_t>(1, hi - lo < parts ? hi - lo + 1 : parts);
+
+        std::vector<std::string> bounds{prefix};
+        for (size_t i = 1; i < parts; ++i) {
+            uint64_t v = lo + (hi - lo) / parts * i;
+            std::string b = first.substr(0, common);
+            for (size_t d = 0; d < width; ++d) {
+                size_t shift = (width - 1 - d) * (hex ? 4 : 8);
+                b.push_back(hex ? HEX[(v >> shift) & 15] : static_cast<char>(v >> shift));
+            }
+            bounds.push_back(b);
+        }
+        bounds.push_back(end);
+
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < parts; ++i) {
+            threads.emplace_back([&, i]() {
+                for (Cursor c(db_, bounds[i], bounds[i + 1]); c.valid(); c.next())
+                    visit(c.key(), c.value());
+            });
+        }
+        for (auto& t : threads) t.join();
+    }
+
     // Scan prefix for metadata keys
     std::vector<std::pair<std::string, std::string>> scan_prefix(const std::string& prefix) {
         std::vector<std::pair<std::string, std::string>> result;
-        if (!db_) return result;
-        rocksdb::ReadOptions ro;
-        ro.prefix_same_as_start = true;
-        std::unique_ptr<rocksdb::Iterator> it(db_->NewIterator(ro));
-        for (it->Seek(prefix); it->Valid() && it->key().starts_with(prefix); it->Next()) {
-            result.emplace_back(it->key().ToString(), it->value().ToString());
-        }
+        for_each_prefix(prefix, [&](std::string_view k, std::string_view v) {
+            result.emplace_back(std::string(k), std::string(v));
+        });
         return result;
     }
 
@@ -139,14 +386,50 @@ public:
         }
     }
 
+    // Drops every key starting with `prefix`. SST files that lie entirely
+    // inside the range are unlinked right away; the range tombstone covers
+    // the rest until compaction drops it.
     void delete_prefix(const std::string& prefix) {
         if (!db_) return;
-        rocksdb::Status status = db_->DeleteRange(rocksdb::WriteOptions(), db_->DefaultColumnFamily(), prefix, prefix + "\xff");
+        std::string end = prefix_upper_bound(prefix);
+        rocksdb::Slice begin_slice(prefix), end_slice(end);
+        // `end` is exclusive, as for DeleteRange below
+        rocksdb::Status status = rocksdb::DeleteFilesInRange(
+            db_, db_->DefaultColumnFamily(), &begin_slice, end.empty() ? nullptr : &end_slice,
+            /*include_end=*/false);
+        if (!status.ok()) {
+            std::cerr << "RocksDB: Failed to drop files in range: " << status.ToString() << std::endl;
+        }
+        status = end.empty()
+            ? db_->DeleteRange(rocksdb::WriteOptions(), db_->DefaultColumnFamily(), prefix, prefix + "\xff")
+            : db_->DeleteRange(rocksdb::WriteOptions(), db_->DefaultColumnFamily(), prefix, end);
         if (!status.ok()) {
             std::cerr << "RocksDB: Failed to delete prefix: " << status.ToString() << std::endl;
         }
     }
 
+    // Distinct <group> parts of keys of the form "<group>/<rest>", sorted.
+    // Seeks past each group, so this costs one seek per group rather than a
+    // scan of every row.
+    std::vector<std::string> list_groups() {
+        std::vector<std::string> groups;
+        if (!db_) return groups;
+        std::unique_ptr<rocksdb::Iterator> it(db_->NewIterator(rocksdb::ReadOptions()));
+        for (it->SeekToFirst(); it->Valid();) {
+            std::string key = it->key().ToString();
+            auto pos = key.find('/');
+            if (pos == std::string::npos) {
+                it->Next();
+                continue;
+            }
+            groups.push_back(key.substr(0, pos));
+            std::string next = prefix_upper_bound(key.substr(0, pos + 1));
+            if (next.empty()) break;
+            it->Seek(next);
+        }
+        return groups;
+    }
+
     void flush() {
         if (!db_) return;
         rocksdb::Status status = db_->Flush(rocksdb::FlushOptions());
@@ -0,0 +1,868 @@
+#ifndef SEGMENT_STORE_HPP
+#define SEGMENT_STORE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+#ifdef SEGMENT_STORE_IO_URING
+#include <liburing.h>
+#endif
+
+// Append-only store for checkpoint data. Checkpoints are written once, read
+// only on recovery and dropped a whole snapshot at a time, so there is no
+// memtable, WAL or compaction: rows are packed into 2 MB segments that are
+// written with O_DIRECT (through io_uring when SEGMENT_STORE_IO_URING is set)
+// and carry a sorted footer index.
+//
+// Keys of the form "<group>/<rest>" are stored in the segments of <group>
+// (one checkpoint snapshot, see snapshot_manifest.hpp), and delete_prefix()
+// on a group unlinks its segments. Keys without a '/' are small metadata
+// (manifest, snapshot pointer) kept in memory and persisted atomically to a
+// single file after all pending segments are durable.
+//
+// Segments are only sorted internally, so cursor() and for_each_prefix()
+// stream a prefix in key order by merging the footer indexes of its
+// segments and reading values as they are reached; scan_prefix()
+// materializes the whole prefix instead.
+//
+// A row that fails to reach disk marks its group as lost until the group is
+// dropped. Failures are kept per group rather than per flush because any
+// caller's flush can be the one that sees a segment write fail: a commit
+// only publishes metadata if the groups written in the same batch are
+// intact, and callers that wrote a group in earlier batches check it with
+// flush(prefix) before publishing metadata that points at it.
+//
+// Segment file layout, padded to BLOCK_SIZE:
+//   record*  := u32 klen | u32 vlen | key | value
+//   index*   := u32 klen | u32 record offset | key   (sorted by key)
+//   ...padding...
+//   Footer   (last bytes of the file)
+class SegmentStore {
+public:
+    static constexpr size_t SEGMENT_SIZE = 2 << 20;
+    static constexpr size_t BLOCK_SIZE = 4096;   // O_DIRECT alignment
+    static constexpr uint64_t FOOTER_MAGIC = 0x31474553444f44ull; // "DODSEG1"
+
+    using Batch = std::vector<std::pair<std::string, std::string>>;
+
+private:
+    struct Footer {
+        uint64_t magic;
+        uint32_t data_size;
+        uint32_t index_offset;
+        uint32_t index_size;
+        uint32_t record_count;
+    };
+
+    struct IndexEntry {
+        std::string key;
+        uint32_t offset;
+    };
+
+    // Segment currently being filled for one group
+    struct ActiveSegment {
+        char* buf = nullptr;
+        size_t data_size = 0;
+        size_t index_size = 0;
+        std::vector<IndexEntry> index;
+    };
+
+    struct PendingWrite {
+        int fd;
+        char* buf;
+        size_t len;
+        std::string group;
+        bool abandoned = false;  // no longer waited for, see reap_one()
+    };
+
+    std::string dir_;
+    bool open_ = false;
+    std::mutex mu_;
+    std::map<std::string, std::string> meta_;
+    std::map<std::string, ActiveSegment> active_;
+    std::map<std::string, uint32_t> next_seq_;        // per group
+    std::vector<char*> free_buffers_;
+    std::vector<std::pair<int, std::string>> unsynced_;  // (fd, group)
+    std::set<std::string> failed_groups_;               // until dropped
+    std::atomic<bool> warned_no_direct_{false};
+#ifdef SEGMENT_STORE_IO_URING
+    struct io_uring ring_;
+    std::vector<PendingWrite*> submitted_;  // completion not reaped yet
+    size_t inflight_ = 0;                   // submitted_ not abandoned
+#endif
+
+    static std::string group_of(const std::string& key) {
+        auto pos = key.find('/');
+        return pos == std::string::npos ? std::string() : key.substr(0, pos);
+    }
+
+    static size_t align_up(size_t n) {
+        return (n + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE;
+    }
+
+    std::string segment_path(const std::string& group, uint32_t seq) const {
+        char suffix[32];
+        snprintf(suffix, sizeof(suffix), ".%06u.seg", seq);
+        return dir_ + "/" + group + suffix;
+    }
+
+    // Sealed segments of every group, oldest first within a group
+    std::vector<std::pair<std::string, std::string>> list_segments() const {
+        std::vector<std::pair<std::string, std::string>> out;  // (group, path)
+        for (auto& e : std::filesystem::directory_iterator(dir_)) {
+            std::string name = e.path().filename().string();
+            if (name.size() < 12 || name.compare(name.size() - 4, 4, ".seg") != 0) continue;
+            out.emplace_back(name.substr(0, name.size() - 11), e.path().string());
+        }
+        std::sort(out.begin(), out.end());
+        return out;
+    }
+
+    int open_direct(const std::string& path, int flags) {
+        int fd = ::open(path.c_str(), flags | O_DIRECT, 0644);
+        if (fd < 0 && errno == EINVAL) {
+            // e.g. tmpfs: fall back to buffered I/O
+            if (!warned_no_direct_.exchange(true))
+                std::cerr << "SegmentStore: O_DIRECT unsupported in " << dir_ << ", using buffered I/O" << std::endl;
+            fd = ::open(path.c_str(), flags, 0644);
+        }
+        return fd;
+    }
+
+    char* acquire_buffer() {
+        if (!free_buffers_.empty()) {
+            char* b = free_buffers_.back();
+            free_buffers_.pop_back();
+            return b;
+        }
+        return static_cast<char*>(aligned_alloc(BLOCK_SIZE, SEGMENT_SIZE));
+    }
+
+    void mark_failed(const std::string& group) {
+        failed_groups_.insert(group);
+    }
+
+    // True if a row of a group matching `prefix` never reached disk
+    bool lost(const std::string& prefix) const {
+        for (auto& group : failed_groups_)
+            if (group_matches(group, prefix)) return true;
+        return false;
+    }
+
+    void complete_write(const PendingWrite& w, ssize_t res) {
+        if (res != static_cast<ssize_t>(w.len)) {
+            std::cerr << "SegmentStore: Failed to write segment of " << w.group << ": "
+                      << (res < 0 ? strerror(-res) : "short write") << std::endl;
+            mark_failed(w.group);
+        }
+        unsynced_.emplace_back(w.fd, w.group);
+        free_buffers_.push_back(w.buf);
+    }
+
+#ifdef SEGMENT_STORE_IO_URING
+    // Collects one completion. If the ring cannot deliver completions any
+    // more, every write in flight is counted as lost and abandoned, so
+    // wait_writes() returns; the kernel may still be reading their buffers,
+    // which are only reused if their completion turns up later.
+    void reap_one() {
+        struct io_uring_cqe* cqe;
+        int r;
+        while ((r = io_uring_wait_cqe(&ring_, &cqe)) == -EINTR)
+            ;
+        if (r < 0) {
+            std::cerr << "SegmentStore: Failed to wait for segment writes: " << strerror(-r) << std::endl;
+            for (auto* w : submitted_) {
+                if (w->abandoned) continue;
+                w->abandoned = true;
+                mark_failed(w->group);
+                ::close(w->fd);
+            }
+            inflight_ = 0;
+            return;
+        }
+        auto* w = static_cast<PendingWrite*>(io_uring_cqe_get_data(cqe));
+        io_uring_cqe_seen(&ring_, cqe);
+        submitted_.erase(std::find(submitted_.begin(), submitted_.end(), w));
+        if (w->abandoned) {
+            free_buffers_.push_back(w->buf);
+        } else {
+            complete_write(*w, cqe->res);
+            --inflight_;
+        }
+        delete w;
+    }
+#endif
+
+    void submit_write(int fd, char* buf, size_t len, const std::string& group) {
+#ifdef SEGMENT_STORE_IO_URING
+        struct io_uring_sqe* sqe;
+        while (!(sqe = io_uring_get_sqe(&ring_)) && inflight_) reap_one();
+        if (!sqe) {
+            std::cerr << "SegmentStore: No submission slot for a segment of " << group << std::endl;
+            mark_failed(group);
+            ::close(fd);
+            free_buffers_.push_back(buf);
+            return;
+        }
+        auto* w = new PendingWrite{fd, buf, len, group};
+        io_uring_prep_write(sqe, fd, buf, len, 0);
+        io_uring_sqe_set_data(sqe, w);
+        io_uring_submit(&ring_);
+        submitted_.push_back(w);
+        ++inflight_;
+#else
+        ssize_t res = pwrite(fd, buf, len, 0);
+        complete_write({fd, buf, len, group}, res < 0 ? -errno : res);
+#endif
+    }
+
+    void wait_writes() {
+#ifdef SEGMENT_STORE_IO_URING
+        while (inflight_) reap_one();
+#endif
+    }
+
+    // Appends the footer index to the active segment of `group` and writes it out
+    void seal(const std::string& group, ActiveSegment& seg) {
+        if (seg.index.empty()) return;
+        std::stable_sort(seg.index.begin(), seg.index.end(),
+                         [](const IndexEntry& a, const IndexEntry& b) { return a.key < b.key; });
+
+        char* p = seg.buf + seg.data_size;
+        for (auto& e : seg.index) {
+            uint32_t klen = e.key.size();
+            memcpy(p, &klen, sizeof(klen));
+            memcpy(p + 4, &e.offset, sizeof(e.offset));
+            memcpy(p + 8, e.key.data(), klen);
+            p += 8 + klen;
+        }
+
+        size_t file_size = align_up(seg.data_size + seg.index_size + sizeof(Footer));
+        memset(p, 0, file_size - (p - seg.buf));
+        Footer f{FOOTER_MAGIC, static_cast<uint32_t>(seg.data_size), static_cast<uint32_t>(seg.data_size),
+                 static_cast<uint32_t>(seg.index_size), static_cast<uint32_t>(seg.index.size())};
+        memcpy(seg.buf + file_size - sizeof(Footer), &f, sizeof(f));
+
+        std::string path = segment_path(group, next_seq_[group]++);
+        int fd = open_direct(path, O_CREAT | O_WRONLY | O_TRUNC);
+        if (fd < 0) {
+            std::cerr << "SegmentStore: Failed to create " << path << ": " << strerror(errno) << std::endl;
+            free_buffers_.push_back(seg.buf);
+            mark_failed(group);
+        } else {
+            submit_write(fd, seg.buf, file_size, group);
+        }
+        seg = ActiveSegment();
+    }
+
+    void append(const std::string& group, const std::string& key, const std::string& value) {
+        size_t rec = 8 + key.size() + value.size();
+        size_t idx = 8 + key.size();
+        if (rec + idx + sizeof(Footer) > SEGMENT_SIZE) {
+            std::cerr << "SegmentStore: Record too large for a segment: " << key << std::endl;
+            mark_failed(group);
+            return;
+        }
+        ActiveSegment& seg = active_[group];
+        if (seg.buf && seg.data_size + rec + seg.index_size + idx + sizeof(Footer) > SEGMENT_SIZE)
+            seal(group, seg);
+        if (!seg.buf) seg.buf = acquire_buffer();
+
+        char* p = seg.buf + seg.data_size;
+        uint32_t klen = key.size(), vlen = value.size();
+        memcpy(p, &klen, sizeof(klen));
+        memcpy(p + 4, &vlen, sizeof(vlen));
+        memcpy(p + 8, key.data(), klen);
+        memcpy(p + 8 + klen, value.data(), vlen);
+        seg.index.push_back({key, static_cast<uint32_t>(seg.data_size)});
+        seg.data_size += rec;
+        seg.index_size += idx;
+    }
+
+    // Seals every active segment and makes all written segments durable;
+    // rows that did not make it mark their group as lost
+    void flush_locked() {
+        for (auto& [group, seg] : active_) seal(group, seg);
+        active_.clear();
+        wait_writes();
+        for (auto& [fd, group] : unsynced_) {
+            if (fdatasync(fd) != 0) {
+                std::cerr << "SegmentStore: Failed to sync segment of " << group << ": " << strerror(errno) << std::endl;
+                mark_failed(group);
+            }
+            ::close(fd);
+        }
+        unsynced_.clear();
+    }
+
+    bool persist_meta() {
+        std::string tmp = dir_ + "/meta.tmp";
+        std::string data;
+        for (auto& [k, v] : meta_) {
+            uint32_t klen = k.size(), vlen = v.size();
+            data.append(reinterpret_cast<const char*>(&klen), sizeof(klen));
+            data.append(reinterpret_cast<const char*>(&vlen), sizeof(vlen));
+            data += k;
+            data += v;
+        }
+        int fd = ::open(tmp.c_str(), O_CREAT | O_WRONLY | O_TRUNC, 0644);
+        if (fd < 0 || write(fd, data.data(), data.size()) != static_cast<ssize_t>(data.size()) || fsync(fd) != 0) {
+            std::cerr << "SegmentStore: Failed to write metadata: " << strerror(errno) << std::endl;
+            if (fd >= 0) ::close(fd);
+            return false;
+        }
+        ::close(fd);
+        if (rename(tmp.c_str(), (dir_ + "/meta").c_str()) != 0) {
+            std::cerr << "SegmentStore: Failed to publish metadata: " << strerror(errno) << std::endl;
+            return false;
+        }
+        sync_dir();
+        return true;
+    }
+
+    void load_meta() {
+        int fd = ::open((dir_ + "/meta").c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat sb;
+        fstat(fd, &sb);
+        std::string data(sb.st_size, '\0');
+        if (read(fd, data.data(), data.size()) != static_cast<ssize_t>(data.size())) data.clear();
+        ::close(fd);
+        size_t off = 0;
+        while (off + 8 <= data.size()) {
+            uint32_t klen, vlen;
+            memcpy(&klen, data.data() + off, 4);
+            memcpy(&vlen, data.data() + off + 4, 4);
+            if (off + 8 + klen + vlen > data.size()) break;
+            meta_[data.substr(off + 8, klen)] = data.substr(off + 8 + klen, vlen);
+            off += 8 + klen + vlen;
+        }
+    }
+
+    void sync_dir() {
+        int fd = ::open(dir_.c_str(), O_RDONLY | O_DIRECTORY);
+        if (fd >= 0) {
+            fsync(fd);
+            ::close(fd);
+        }
+    }
+
+    // Reads a whole sealed segment into `buf` (SEGMENT_SIZE bytes) and
+    // returns its footer; magic is 0 on failure
+    Footer read_segment(const std::string& path, char* buf) {
+        Footer f{};
+        int fd = open_direct(path, O_RDONLY);
+        if (fd < 0) return f;
+        struct stat sb;
+        fstat(fd, &sb);
+        size_t size = sb.st_size;
+        if (size >= sizeof(Footer) && size <= SEGMENT_SIZE &&
+            pread(fd, buf, align_up(size), 0) == static_cast<ssize_t>(size)) {
+            memcpy(&f, buf + size - sizeof(Footer), sizeof(f));
+        }
+        ::close(fd);
+        if (f.magic != FOOTER_MAGIC) {
+            std::cerr << "SegmentStore: Corrupted segment " << path << std::endl;
+            f.magic = 0;
+        }
+        return f;
+    }
+
+    // Visits (key, record offset) of a sealed segment in key order
+    template<typename Visitor>
+    static void for_each_index(const char* buf, const Footer& f, Visitor&& visit) {
+        const char* p = buf + f.index_offset;
+        for (uint32_t i = 0; i < f.record_count; ++i) {
+            uint32_t klen, off;
+            memcpy(&klen, p, 4);
+            memcpy(&off, p + 4, 4);
+            visit(std::string_view(p + 8, klen), off);
+            p += 8 + klen;
+        }
+    }
+
+    static std::string_view record_value(const char* buf, uint32_t off) {
+        uint32_t klen, vlen;
+        memcpy(&klen, buf + off, 4);
+        memcpy(&vlen, buf + off + 4, 4);
+        return std::string_view(buf + off + 8 + klen, vlen);
+    }
+
+    // A group is relevant to `prefix` if one is a prefix of the other
+    static bool group_matches(const std::string& group, const std::string& prefix) {
+        std::string g = group + "/";
+        return g.compare(0, prefix.size(), prefix) == 0 || prefix.compare(0, g.size(), g) == 0;
+    }
+
+public:
+    SegmentStore() {
+#ifdef SEGMENT_STORE_IO_URING
+        if (io_uring_queue_init(64, &ring_, 0) < 0) {
+            throw std::runtime_error("SegmentStore: Failed to set up io_uring");
+        }
+#endif
+    }
+
+    ~SegmentStore() {
+        close();
+        for (char* b : free_buffers_) free(b);
+#ifdef SEGMENT_STORE_IO_URING
+        io_uring_queue_exit(&ring_);
+#endif
+    }
+
+    bool open(const std::string& dir) {
+        std::lock_guard<std::mutex> lg(mu_);
+        std::error_code ec;
+        std::filesystem::create_directories(dir, ec);
+        if (ec) {
+            std::cerr << "SegmentStore: Failed to open DB: " << ec.message() << std::endl;
+            return false;
+        }
+        dir_ = dir;
+        for (auto& [group, path] : list_segments()) {
+            uint32_t seq = std::strtoul(path.c_str() + path.size() - 10, nullptr, 10);
+            next_seq_[group] = std::max(next_seq_[group], seq + 1);
+        }
+        load_meta();
+        open_ = true;
+        return true;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lg(mu_);
+        if (!open_) return;
+        flush_locked();
+        for (auto& group : failed_groups_)
+            std::cerr << "SegmentStore: Rows of " << group << " were lost" << std::endl;
+        open_ = false;
+    }
+
+    bool put(const std::string& key, const std::string& value) {
+        Batch b{{key, value}};
+        return commit_batch(b);
+    }
+
+    bool get(const std::string& key, std::string& value) {
+        std::lock_guard<std::mutex> lg(mu_);
+        std::string group = group_of(key);
+        if (group.empty()) {
+            auto it = meta_.find(key);
+            if (it == meta_.end()) {
+                value.clear();
+                return false;
+            }
+            value = it->second;
+            return true;
+        }
+
+        auto it = active_.find(group);
+        if (it != active_.end()) {
+            // newest write wins
+            for (auto e = it->second.index.rbegin(); e != it->second.index.rend(); ++e) {
+                if (e->key == key) {
+                    value = record_value(it->second.buf, e->offset);
+                    return true;
+                }
+            }
+        }
+
+        wait_writes();
+        char* buf = acquire_buffer();
+        bool found = false;
+        auto segments = list_segments();
+        for (auto s = segments.rbegin(); s != segments.rend() && !found; ++s) {
+            if (s->first != group) continue;
+            Footer f = read_segment(s->second, buf);
+            if (!f.magic) continue;
+            for_each_index(buf, f, [&](std::string_view k, uint32_t off) {
+                if (k == key) {
+                    value = record_value(buf, off);
+                    found = true;
+                }
+            });
+        }
+        free_buffers_.push_back(buf);
+        if (!found) value.clear();
+        return found;
+    }
+
+    // Atomic batch API used by Checkpointer
+    Batch create_batch() {
+        return Batch();
+    }
+
+    void add_to_batch(Batch& batch, const std::string& key, const std::string& value) {
+        batch.emplace_back(key, value);
+    }
+
+    // Rows are buffered into their group's segment. A batch that touches
+    // metadata first makes every pending segment durable, so the metadata
+    // never points at data that could be lost: if a group written in this
+    // batch lost a row, the metadata keeps its old values and the commit
+    // returns false.
+    bool commit_batch(Batch& batch) {
+        std::lock_guard<std::mutex> lg(mu_);
+        if (!open_) return false;
+        std::vector<const std::pair<std::string, std::string>*> meta;
+        std::set<std::string> groups;
+        for (auto& kv : batch) {
+            std::string group = group_of(kv.first);
+            if (group.empty()) {
+                meta.push_back(&kv);
+            } else {
+                append(group, kv.first, kv.second);
+                groups.insert(group);
+            }
+        }
+        if (meta.empty()) return true;
+        flush_locked();
+        bool intact = std::none_of(groups.begin(), groups.end(),
+                                   [&](const std::string& g) { return failed_groups_.count(g) > 0; });
+        if (!intact) {
+            std::cerr << "SegmentStore: Not publishing metadata over lost rows" << std::endl;
+            return false;
+        }
+        auto prev = meta_;
+        for (auto* kv : meta) meta_[kv->first] = kv->second;
+        if (!persist_meta()) {
+            meta_ = std::move(prev);
+            return false;
+        }
+        return true;
+    }
+
+    // Scan prefix, sorted by key
+    std::vector<std::pair<std::string, std::string>> scan_prefix(const std::string& prefix) {
+        std::vector<std::pair<std::string, std::string>> result;
+        std::lock_guard<std::mutex> lg(mu_);
+        if (!open_) return result;
+        wait_writes();
+
+        auto matches = [&](std::string_view k) { return k.compare(0, prefix.size(), prefix) == 0; };
+        for (auto& [k, v] : meta_)
+            if (matches(k)) result.emplace_back(k, v);
+
+        char* buf = acquire_buffer();
+        for (auto& [group, path] : list_segments()) {
+            if (!group_matches(group, prefix)) continue;
+            Footer f = read_segment(path, buf);
+            if (!f.magic) continue;
+            for_each_index(buf, f, [&](std::string_view k, uint32_t off) {
+                if (matches(k)) result.emplace_back(std::string(k), std::string(record_value(buf, off)));
+            });
+        }
+        free_buffers_.push_back(buf);
+
+        // Rows not sealed yet are newer than any sealed segment of their group
+        for (auto& [group, seg] : active_) {
+            if (!group_matches(group, prefix)) continue;
+            for (auto& e : seg.index)
+                if (matches(e.key)) result.emplace_back(e.key, std::string(record_value(seg.buf, e.offset)));
+        }
+
+        // Segments are visited oldest first, so the last duplicate is the newest
+        std::stable_sort(result.begin(), result.end(),
+                         [](const auto& a, const auto& b) { return a.first < b.first; });
+        auto last = std::unique(result.rbegin(), result.rend(),
+                                [](const auto& a, const auto& b) { return a.first == b.first; });
+        result.erase(result.begin(), last.base());
+        return result;
+    }
+
+    // Sorted, streaming view over the entries starting with a prefix, with
+    // the newest write of a key winning. Segments of a group are only sorted
+    // internally, so this is a k-way merge over their footer indexes: only
+    // the indexes are held in memory, and values are read through a small
+    // window per segment as the cursor reaches them. Rows not sealed yet and
+    // matching metadata are copied when the cursor is made. Segments dropped
+    // while the cursor is open stay readable through its descriptors.
+    class Cursor {
+        static constexpr size_t WINDOW = 64 << 10;
+
+        struct Source {
+            int fd = -1;                     // -1: values held in `values`
+            std::vector<IndexEntry> index;   // sorted, one entry per key
+            std::vector<std::string> values; // in-memory sources only
+            size_t pos = 0;
+            std::string window;              // segment bytes at window_off
+            size_t window_off = 0;
+            size_t data_size = 0;
+
+            Source() = default;
+            Source(Source&& o) noexcept
+                : fd(std::exchange(o.fd, -1)), index(std::move(o.index)), values(std::move(o.values)),
+                  pos(o.pos), window(std::move(o.window)), window_off(o.window_off), data_size(o.data_size) {}
+            ~Source() { if (fd >= 0) ::close(fd); }
+
+            bool valid() const { return pos < index.size(); }
+
+            // Makes segment bytes [off, off + len) available in `window`
+            const char* bytes(size_t off, size_t len) {
+                if (off + len > data_size) return nullptr;
+                if (off < window_off || off + len > window_off + window.size()) {
+                    size_t want = std::min(std::max(len, WINDOW), data_size - off);
+                    window.resize(want);
+                    ssize_t n = pread(fd, window.data(), want, off);
+                    window.resize(n < 0 ? 0 : n);
+                    window_off = off;
+                    if (window.size() < len) return nullptr;
+                }
+                return window.data() + (off - window_off);
+            }
+
+            std::string_view value() {
+                if (fd < 0) return values[pos];
+                uint32_t off = index[pos].offset, klen, vlen;
+                const char* h = bytes(off, 8);
+                if (!h) return {};
+                memcpy(&klen, h, 4);
+                memcpy(&vlen, h + 4, 4);
+                const char* r = bytes(off, 8 + klen + vlen);
+                return r ? std::string_view(r + 8 + klen, vlen) : std::string_view();
+            }
+        };
+
+        std::vector<Source> sources_;  // oldest first
+        size_t current_ = 0;           // newest source holding the smallest key
+
+        // Keeps the last (newest) entry of each run of equal keys
+        static void dedupe(Source& src) {
+            size_t out = 0;
+            for (size_t i = 0; i < src.index.size(); ++i) {
+                if (i + 1 < src.index.size() && src.index[i + 1].key == src.index[i].key) continue;
+                if (out != i) {
+                    src.index[out] = std::move(src.index[i]);
+                    if (!src.values.empty()) src.values[out] = std::move(src.values[i]);
+                }
+                ++out;
+            }
+            src.index.resize(out);
+            if (!src.values.empty()) src.values.resize(out);
+        }
+
+        void settle() {
+            current_ = sources_.size();
+            for (size_t s = 0; s < sources_.size(); ++s) {
+                if (!sources_[s].valid()) continue;
+                if (current_ == sources_.size() ||
+                    sources_[s].index[sources_[s].pos].key <= sources_[current_].index[sources_[current_].pos].key)
+                    current_ = s;
+            }
+        }
+
+        friend class SegmentStore;
+
+    public:
+        bool valid() const { return current_ < sources_.size(); }
+        std::string_view key() const { return sources_[current_].index[sources_[current_].pos].key; }
+        std::string_view value() { return sources_[current_].value(); }
+
+        void next() {
+            std::string k(key());
+            for (auto& src : sources_)
+                if (src.valid() && src.index[src.pos].key == k) ++src.pos;
+            settle();
+        }
+    };
+
+    Cursor cursor(const std::string& prefix) {
+        Cursor c;
+        auto matches = [&](std::string_view k) { return k.compare(0, prefix.size(), prefix) == 0; };
+        std::lock_guard<std::mutex> lg(mu_);
+        if (!open_) return c;
+        wait_writes();
+
+        for (auto& [group, path] : list_segments()) {
+            if (!group_matches(group, prefix)) continue;
+            Cursor::Source src;
+            src.fd = ::open(path.c_str(), O_RDONLY);
+            Footer f{};
+            struct stat sb;
+            if (src.fd < 0 || fstat(src.fd, &sb) != 0 || static_cast<size_t>(sb.st_size) < sizeof(Footer) ||
+                pread(src.fd, &f, sizeof(f), sb.st_size - sizeof(f)) != sizeof(f) || f.magic != FOOTER_MAGIC) {
+                std::cerr << "SegmentStore: Corrupted segment " << path << std::endl;
+                continue;
+            }
+            std::string index(f.index_size, '\0');
+            if (pread(src.fd, index.data(), index.size(), f.index_offset) != static_cast<ssize_t>(index.size())) {
+                std::cerr << "SegmentStore: Corrupted segment " << path << std::endl;
+                continue;
+            }
+            f.index_offset = 0;
+            for_each_index(index.data(), f, [&](std::string_view k, uint32_t off) {
+                if (matches(k)) src.index.push_back({std::string(k), off});
+            });
+            src.data_size = f.data_size;
+            Cursor::dedupe(src);
+            if (!src.index.empty()) c.sources_.push_back(std::move(src));
+        }
+
+        // Rows not sealed yet are newer than any sealed segment of their
+        // group; metadata shares no key with a group
+        Cursor::Source mem;
+        for (auto& [k, v] : meta_)
+            if (matches(k)) {
+                mem.index.push_back({k, 0});
+                mem.values.push_back(v);
+            }
+        for (auto& [group, seg] : active_) {
+            if (!group_matches(group, prefix)) continue;
+            for (auto& e : seg.index)
+                if (matches(e.key)) {
+                    mem.index.push_back({e.key, 0});
+                    mem.values.emplace_back(record_value(seg.buf, e.offset));
+                }
+        }
+        std::vector<size_t> order(mem.index.size());
+        for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+        std::stable_sort(order.begin(), order.end(),
+                         [&](size_t a, size_t b) { return mem.index[a].key < mem.index[b].key; });
+        Cursor::Source sorted;
+        for (size_t i : order) {
+            sorted.index.push_back(std::move(mem.index[i]));
+            sorted.values.push_back(std::move(mem.values[i]));
+        }
+        Cursor::dedupe(sorted);
+        if (!sorted.index.empty()) c.sources_.push_back(std::move(sorted));
+
+        c.settle();
+        return c;
+    }
+
+    // Streams the entries starting with `prefix` to visit(key, value) in key
+    // order without materializing them. The views are only valid during the
+    // call.
+    template<typename Visitor>
+    void for_each_prefix(const std::string& prefix, Visitor&& visit) {
+        for (Cursor c = cursor(prefix); c.valid(); c.next())
+            visit(c.key(), c.value());
+    }
+
+    // Reads the sealed segments matching `prefix` on `parts` threads and
+    // streams their rows to visit(key, value) straight from the segment
+    // buffers, in no particular order. Rows still in an active segment are
+    // visited first on the calling thread. A key written more than once into
+    // one group is visited once per copy, so callers that need newest-wins
+    // must use scan_prefix(); checkpoint snapshots write each row once.
+    template<typename Visitor>
+    void parallel_for_each_prefix(const std::string& prefix, size_t parts, Visitor&& visit) {
+        auto matches = [&](std::string_view k) { return k.compare(0, prefix.size(), prefix) == 0; };
+        std::vector<std::string> paths;
+        std::vector<char*> bufs;
+        {
+            std::lock_guard<std::mutex> lg(mu_);
+            if (!open_) return;
+            wait_writes();
+            for (auto& [k, v] : meta_)
+                if (matches(k)) visit(std::string_view(k), std::string_view(v));
+            for (auto& [group, seg] : active_) {
+                if (!group_matches(group, prefix)) continue;
+                for (auto& e : seg.index)
+                    if (matches(e.key)) visit(std::string_view(e.key), record_value(seg.buf, e.offset));
+            }
+            for (auto& [group, path] : list_segments())
+                if (group_matches(group, prefix)) paths.push_back(path);
+            parts = std::max<size_t>(1, std::min(parts, paths.size()));
+            for (size_t i = 0; i < parts; ++i) bufs.push_back(acquire_buffer());
+        }
+
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < parts && !paths.empty(); ++t) {
+            threads.emplace_back([&, t]() {
+                char* buf = bufs[t];
+                for (size_t i = t; i < paths.size(); i += parts) {
+                    Footer f = read_segment(paths[i], buf);
+                    if (!f.magic) continue;
+                    for_each_index(buf, f, [&](std::string_view k, uint32_t off) {
+                        if (matches(k)) visit(k, record_value(buf, off));
+                    });
+                }
+            });
+        }
+        for (auto& t : threads) t.join();
+
+        std::lock_guard<std::mutex> lg(mu_);
+        for (char* b : bufs) free_buffers_.push_back(b);
+    }
+
+    void delete_key(const std::string& key) {
+        std::lock_guard<std::mutex> lg(mu_);
+        if (group_of(key).empty() && meta_.erase(key)) {
+            persist_meta();
+            return;
+        }
+        std::cerr << "SegmentStore: Cannot delete a single row: " << key << std::endl;
+    }
+
+    // Distinct groups with sealed or pending segments, sorted
+    std::vector<std::string> list_groups() {
+        std::lock_guard<std::mutex> lg(mu_);
+        std::vector<std::string> groups;
+        if (!open_) return groups;
+        for (auto& [group, path] : list_segments()) groups.push_back(group);
+        for (auto& [group, seg] : active_) groups.push_back(group);
+        std::sort(groups.begin(), groups.end());
+        groups.erase(std::unique(groups.begin(), groups.end()), groups.end());
+        return groups;
+    }
+
+    // Drops whole groups by unlinking their segments
+    void delete_prefix(const std::string& prefix) {
+        std::lock_guard<std::mutex> lg(mu_);
+        if (!open_) return;
+        for (auto it = failed_groups_.begin(); it != failed_groups_.end();) {
+            if ((*it + "/").compare(0, prefix.size(), prefix) == 0)
+                it = failed_groups_.erase(it);
+            else
+                ++it;
+        }
+        for (auto it = active_.begin(); it != active_.end();) {
+            if ((it->first + "/").compare(0, prefix.size(), prefix) == 0) {
+                if (it->second.buf) free_buffers_.push_back(it->second.buf);
+                it = active_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        wait_writes();
+        for (auto& [group, path] : list_segments()) {
+            if (!group_matches(group, prefix)) continue;
+            if ((group + "/").size() < prefix.size()) {
+                std::cerr << "SegmentStore: Cannot delete part of group " << group << std::endl;
+                continue;
+            }
+            if (unlink(path.c_str()) != 0)
+                std::cerr << "SegmentStore: Failed to delete " << path << ": " << strerror(errno) << std::endl;
+        }
+        sync_dir();
+    }
+
+    // Makes every pending row durable. False if a group matching `prefix`
+    // (by default, any group) lost a row since it was created.
+    bool flush(const std::string& prefix = std::string()) {
+        std::lock_guard<std::mutex> lg(mu_);
+        if (!open_) return false;
+        flush_locked();
+        sync_dir();
+        return !lost(prefix);
+    }
+};
+
+#endif // SEGMENT_STORE_HPP
@@ -0,0 +1,83 @@
+#ifndef SNAPSHOT_MANIFEST_HPP
+#define SNAPSHOT_MANIFEST_HPP
+
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Checkpoint data is laid out snapshot-major:
+//   "b<snap>/<row>"  full base snapshot folded up to <snap>
+//   "i<snap>/<row>"  rows dirtied during incremental checkpoint <snap>
+// Both ids are fixed-width hex, so a prefix scan over one snapshot returns its
+// rows sorted by row id, and one snapshot can be dropped with a single range
+// delete.
+namespace snapshot_keys {
+    static constexpr char BASE = 'b';
+    static constexpr char INCREMENTAL = 'i';
+    static constexpr const char* MANIFEST_KEY = "manifest";
+
+    inline std::string prefix(char kind, uint64_t snap) {
+        char buf[24];
+        snprintf(buf, sizeof(buf), "%c%016" PRIx64 "/", kind, snap);
+        return std::string(buf);
+    }
+
+    inline std::string row_key(char kind, uint64_t snap, uint64_t row) {
+        char buf[40];
+        snprintf(buf, sizeof(buf), "%c%016" PRIx64 "/%016" PRIx64, kind, snap, row);
+        return std::string(buf);
+    }
+
+    // Extracts the row id from a key produced by row_key().
+    inline uint64_t row_id(std::string_view key) {
+        uint64_t id = 0;
+        for (size_t i = 18; i < key.size(); ++i) {
+            char c = key[i];
+            id = (id << 4) | static_cast<uint64_t>(c <= '9' ? c - '0' : c - 'a' + 10);
+        }
+        return id;
+    }
+}
+
+// Lists the snapshots recovery has to read: one base plus the incrementals
+// committed after it, oldest first.
+struct SnapshotManifest {
+    uint64_t base = 0;  // 0 means no base has been folded yet
+    std::vector<uint64_t> incrementals;
+
+    uint64_t latest() const {
+        return incrementals.empty() ? base : incrementals.back();
+    }
+
+    // "base:<id>;incr:<id>,<id>,..."
+    std::string serialize() const {
+        std::string out = "base:" + std::to_string(base) + ";incr:";
+        for (size_t i = 0; i < incrementals.size(); ++i) {
+            if (i) out += ',';
+            out += std::to_string(incrementals[i]);
+        }
+        return out;
+    }
+
+    static bool parse(const std::string& s, SnapshotManifest& m) {
+        auto sep = s.find(";incr:");
+        if (s.rfind("base:", 0) != 0 || sep == std::string::npos) return false;
+        m.base = std::strtoull(s.c_str() + 5, nullptr, 10);
+        m.incrementals.clear();
+        const char* p = s.c_str() + sep + 6;
+        while (*p) {
+            char* end;
+            uint64_t id = std::strtoull(p, &end, 10);
+            if (end == p) return false;
+            m.incrementals.push_back(id);
+            p = (*end == ',') ? end + 1 : end;
+        }
+        return true;
+    }
+};
+
+#endif // SNAPSHOT_MANIFEST_HPP
@@ -0,0 +1,14 @@
+#ifndef STORAGE_HPP
+#define STORAGE_HPP
+
+// Storage backend used for checkpoints, selected at build time
+// (-DCHECKPOINT_STORE=segment in CMake).
+#ifdef SEGMENT_STORE
+#include "segment_store.hpp"
+using CheckpointStore = SegmentStore;
+#else
+#include "rocksdb.hpp"
+using CheckpointStore = RocksDBStore;
+#endif
+
+#endif // STORAGE_HPP